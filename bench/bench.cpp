@@ -0,0 +1,739 @@
+#include "bench.h"
+#include "leptjson.h"
+#include "leptjson_bind.h"
+#include "leptjson_sax.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+std::atomic<size_t> alloc_count(0);
+
+void *operator new(size_t n)
+{
+    alloc_count++;
+    if (void *p = malloc(n ? n : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+/** 生成由 n 条记录组成的数组 */
+std::string make_records(int n)
+{
+    std::string json = "[";
+    char buf[256];
+    for (int i = 0; i < n; i++)
+    {
+        snprintf(buf, sizeof(buf),
+                 "%s{\"id\":%d,\"name\":\"user_%d\",\"score\":%d.%d,\"active\":%s,\"tags\":[\"a\",\"b\",\"c\"],"
+                 "\"pos\":{\"x\":%d,\"y\":%d}}",
+                 i ? "," : "", i, i, i % 100, i % 7, i % 2 ? "true" : "false", i, -i);
+        json += buf;
+    }
+    json += "]";
+    return json;
+}
+
+/** 计时并统计分配次数，f 返回后其中的文档应已释放 */
+template <typename F> void run(const char *name, int rounds, size_t bytes, F f)
+{
+    size_t allocs = alloc_count;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++)
+        f();
+    auto t1 = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(t1 - t0).count() / rounds;
+    printf("%-24s %10.3f ms %10.1f MB/s %12zu allocs\n", name, ms, bytes / ms / 1e3,
+           (alloc_count - allocs) / rounds);
+}
+
+/** 原地解析，每轮先把输入复制到可写缓冲中，复制的时间也计算在内 */
+void bench_insitu(const char *name, const std::string &json, int rounds)
+{
+    std::vector<char> buf(json.size());
+    lept_document d;
+    run(name, rounds, json.size(), [&] {
+        memcpy(buf.data(), json.data(), json.size());
+        if (d.lept_parse_insitu(buf.data(), buf.size()) != LEPT_PARSE_OK)
+            abort();
+    });
+}
+
+void bench_arena(const std::string &json, int rounds)
+{
+    run("parse heap", rounds, json.size(), [&] {
+        lept_value v;
+        if (lept_value::lept_parse(v, json.c_str()) != LEPT_PARSE_OK)
+            abort();
+    });
+    run("parse arena", rounds, json.size(), [&] {
+        lept_document d;
+        if (d.lept_parse(json.c_str()) != LEPT_PARSE_OK)
+            abort();
+    });
+    lept_document d;
+    run("parse arena (reused)", rounds, json.size(), [&] {
+        if (d.lept_parse(json.c_str()) != LEPT_PARSE_OK)
+            abort();
+    });
+    bench_insitu("parse insitu (+copy)", json, rounds);
+}
+
+/** 每条记录 20 个字段的数组，键名较长，与常见的导出数据相似 */
+std::string make_wide_records(int n)
+{
+    static const char *keys[] = {"customer_id", "first_name",  "last_name",     "email_address", "phone_number",
+                                 "street",      "city",        "postal_code",   "country_code",  "created_at",
+                                 "updated_at",  "order_count", "lifetime_value", "last_order_id", "is_subscribed",
+                                 "segment",     "referrer",    "loyalty_points", "preferred_lang", "account_status"};
+    std::string json = "[";
+    for (int i = 0; i < n; i++)
+    {
+        json += i ? ",{" : "{";
+        for (int j = 0; j < 20; j++)
+        {
+            json += j ? ",\"" : "\"";
+            json += keys[j];
+            json += j % 3 ? "\":" + std::to_string(i * 20 + j) : "\":\"v" + std::to_string(i) + "\"";
+        }
+        json += "}";
+    }
+    json += "]";
+    return json;
+}
+
+/** 键驻留与否时文档的占用、解析耗时，以及按键查找的耗时 */
+void bench_intern(const char *name, const std::string &json, int rounds)
+{
+    lept_document interned, plain;
+    plain.lept_set_intern_keys(false);
+    for (int intern = 1; intern >= 0; intern--)
+    {
+        lept_document &d = intern ? interned : plain;
+        std::string label = std::string("parse ") + name + (intern ? " interned" : " plain");
+        run(label.c_str(), rounds, json.size(), [&] {
+            if (d.lept_parse(json) != LEPT_PARSE_OK)
+                abort();
+        });
+    }
+    printf("%-24s %10.1f MB interned %8.1f MB plain %8.1f%% saved\n", name, interned.lept_get_used_size() / 1e6,
+           plain.lept_get_used_size() / 1e6,
+           100.0 - 100.0 * interned.lept_get_used_size() / plain.lept_get_used_size());
+
+    const lept_value &root = interned.lept_get_root();
+    const lept_value &first = root.lept_array_at(0);
+    std::vector<std::string> names;
+    std::vector<lept_value> keys; // 文档中驻留的键
+    for (const lept_member *m = first.lept_object_begin(); m != first.lept_object_end(); m++)
+    {
+        names.emplace_back(m->k.lept_get_string(), m->k.lept_get_string_length());
+        keys.push_back(interned.lept_get_key(names.back().data(), names.back().size()));
+    }
+    size_t found = 0;
+    std::string label = std::string("lookup ") + name + " by text";
+    run(label.c_str(), rounds, json.size(), [&] {
+        for (const lept_value *e = root.lept_array_begin(); e != root.lept_array_end(); e++)
+            for (const std::string &k : names)
+                found += e->lept_find_object_value(k.data(), k.size()) != NULL;
+    });
+    label = std::string("lookup ") + name + " by key";
+    run(label.c_str(), rounds, json.size(), [&] {
+        for (const lept_value *e = root.lept_array_begin(); e != root.lept_array_end(); e++)
+            for (const lept_value &k : keys)
+                found += e->lept_find_object_value(k) != NULL;
+    });
+    if (found != 2 * rounds * names.size() * root.lept_get_array_size())
+        abort();
+}
+
+/** 嵌套深度翻倍时，每层的耗时与分配次数应保持不变 */
+void bench_nested(int rounds)
+{
+    lept_parse_options options;
+    options.max_depth = 2 * 16000; // 每层含一个对象与一个数组
+    for (int depth = 1000; depth <= 16000; depth *= 2)
+    {
+        std::string json;
+        for (int i = 0; i < depth; i++)
+            json += "{\"k\":[";
+        json += "\"leaf\"";
+        for (int i = 0; i < depth; i++)
+            json += "]}";
+
+        size_t allocs = alloc_count;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < rounds; i++)
+        {
+            lept_value v;
+            if (lept_value::lept_parse(v, json.c_str(), options) != LEPT_PARSE_OK)
+                abort();
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / rounds;
+        printf("nested depth %-11d %10.1f ns/level %8.2f allocs/level\n", depth, ns / depth,
+               (double)(alloc_count - allocs) / rounds / depth);
+    }
+}
+
+/** 对成员数不同的对象，比较按键查找与逐个比较键的耗时 */
+void bench_lookup()
+{
+    for (int n : {4, 64, 1024, 65536})
+    {
+        std::string json = "{";
+        for (int i = 0; i < n; i++)
+            json += (i ? ",\"feature_" : "\"feature_") + std::to_string(i) + "\":" + std::to_string(i);
+        json += "}";
+        lept_value v;
+        if (lept_value::lept_parse(v, json.c_str()) != LEPT_PARSE_OK)
+            abort();
+
+        std::vector<std::string> keys;
+        for (int i = 0; i < n; i++)
+            keys.push_back("feature_" + std::to_string((i * 7919) % n));
+        const int lookups = 1 << 20;
+        const int scans = n > 1024 ? 1 << 10 : lookups; // 逐个比较太慢，减少次数
+
+        double sum = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < lookups; i++)
+        {
+            const std::string &k = keys[i % n];
+            sum += v.lept_find_object_value(k.data(), k.size())->lept_get_number();
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        for (int i = 0; i < scans; i++)
+        {
+            const std::string &k = keys[i % n];
+            for (const lept_member *m = v.lept_object_begin(); m != v.lept_object_end(); m++)
+                if (m->k.lept_get_string_length() == k.size() && memcmp(m->k.lept_get_string(), k.data(), k.size()) == 0)
+                {
+                    sum += m->v.lept_get_number();
+                    break;
+                }
+        }
+        auto t2 = std::chrono::steady_clock::now();
+        printf("lookup %-5d keys %14.1f ns/find %10.1f ns/scan (%g)\n", n,
+               std::chrono::duration<double, std::nano>(t1 - t0).count() / lookups,
+               std::chrono::duration<double, std::nano>(t2 - t1).count() / scans, sum);
+    }
+}
+
+/** 以字符串为主的文档：日志行与 base64 数据 */
+std::string make_strings(int n)
+{
+    static const char b64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string json = "[";
+    for (int i = 0; i < n; i++)
+    {
+        if (i)
+            json += ",";
+        json += "\"2026-10-17T12:00:00Z INFO [worker-" + std::to_string(i % 32) +
+                "] request handled in 12ms path=/api/v1/items/" + std::to_string(i) + " status=200\",\"";
+        for (int j = 0; j < 512; j++)
+            json += b64[(i * 31 + j * 7) % 64];
+        json += "\"";
+    }
+    json += "]";
+    return json;
+}
+
+/** 各 SIMD 级别下解析字符串的吞吐量 */
+void bench_strings(int rounds)
+{
+    static const char *names[] = {"strings scalar", "strings sse2", "strings avx2"};
+    std::string json = make_strings(20000);
+    lept_simd_level max = lept_get_simd_level();
+    lept_document d;
+    for (int level = LEPT_SIMD_NONE; level <= max; level++)
+    {
+        lept_set_simd_level((lept_simd_level)level);
+        run(names[level], rounds, json.size(), [&] {
+            if (d.lept_parse(json.c_str()) != LEPT_PARSE_OK)
+                abort();
+        });
+    }
+    lept_set_simd_level(max);
+    bench_insitu("strings insitu (+copy)", json, rounds);
+}
+
+/** 以数字为主的文档：坐标数组 */
+std::string make_numbers(int n)
+{
+    std::string json = "[";
+    char buf[64];
+    for (int i = 0; i < n; i++)
+    {
+        snprintf(buf, sizeof(buf), "%s[%.15g,%.15g]", i ? "," : "", -65.613616999999977 + i * 1e-5,
+                 43.420273000000009 - i * 3e-6);
+        json += buf;
+    }
+    json += "]";
+    return json;
+}
+
+void bench_numbers(int rounds)
+{
+    std::string json = make_numbers(200000);
+    lept_document d;
+    run("numbers", rounds, json.size(), [&] {
+        if (d.lept_parse(json.c_str()) != LEPT_PARSE_OK)
+            abort();
+    });
+}
+
+/** 分块送入增量解析器，与一次性解析比较 */
+void bench_stream(const std::string &json, int rounds)
+{
+    for (size_t chunk = 1 << 10; chunk <= 1 << 20; chunk <<= 5)
+    {
+        char label[64];
+        snprintf(label, sizeof(label), "stream %zuK chunks", chunk >> 10);
+        lept_stream st;
+        run(label, rounds, json.size(), [&] {
+            for (size_t i = 0; i < json.size(); i += chunk)
+                st.lept_feed(json.data() + i, std::min(chunk, json.size() - i));
+            lept_value v;
+            if (st.lept_finish(v) != LEPT_PARSE_OK)
+                abort();
+        });
+    }
+}
+
+/** 什么都不做的事件处理器，用来衡量去掉建树之后的解析开销 */
+struct null_handler
+{
+    size_t events = 0;
+    void lept_null() { events++; }
+    void lept_boolean(bool) { events++; }
+    void lept_number(double) { events++; }
+    void lept_int64(int64_t) { events++; }
+    void lept_uint64(uint64_t) { events++; }
+    void lept_string(const char *, size_t) { events++; }
+    void lept_start_array() { events++; }
+    void lept_end_array(size_t) { events++; }
+    void lept_start_object() { events++; }
+    void lept_key(const char *, size_t) { events++; }
+    void lept_end_object(size_t) { events++; }
+};
+
+/** 事件式解析与构造树的对比 */
+void bench_events(const char *name, const std::string &json, int rounds)
+{
+    std::string label = std::string("events ") + name;
+    run(label.c_str(), rounds, json.size(), [&] {
+        null_handler h;
+        if (lept_parse_events(json.data(), json.size(), h) != LEPT_PARSE_OK)
+            abort();
+    });
+    lept_document d;
+    label = std::string("dom ") + name;
+    run(label.c_str(), rounds, json.size(), [&] {
+        if (d.lept_parse(json.data(), json.size()) != LEPT_PARSE_OK)
+            abort();
+    });
+}
+
+#ifndef _WIN32
+/** 在子进程中执行 f，报告耗时与子进程的峰值常驻内存 */
+template <typename F> void run_process(const char *name, size_t bytes, F f)
+{
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        f();
+        auto t1 = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        printf("%-24s %10.3f ms %10.1f MB/s", name, ms, bytes / ms / 1e3);
+        fflush(stdout);
+        _exit(0);
+    }
+    int status;
+    struct rusage ru;
+    wait4(pid, &status, 0, &ru);
+    printf(" %10.1f MB peak RSS\n", ru.ru_maxrss / 1024.0); // Linux 上单位为 KB
+}
+
+/** 读入缓冲后解析与映射文件解析的对比，每种方式在单独的进程中运行 */
+void bench_file(int n)
+{
+    char path[] = "/tmp/jsonp_bench_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0)
+        abort();
+    size_t bytes;
+    {
+        std::string json = make_records(n);
+        bytes = json.size();
+        if (write(fd, json.data(), bytes) != (ssize_t)bytes)
+            abort();
+        close(fd);
+    } // 释放语料后再创建子进程，避免计入其常驻内存
+
+    run_process("file read + parse", bytes, [&] {
+        std::string json(bytes, '\0');
+        FILE *f = fopen(path, "rb");
+        if (!f || fread(&json[0], 1, bytes, f) != bytes)
+            abort();
+        fclose(f);
+        lept_document d;
+        if (d.lept_parse(json) != LEPT_PARSE_OK)
+            abort();
+    });
+    run_process("file mmap copy", bytes, [&] {
+        lept_document d;
+        if (d.lept_parse_file(path) != LEPT_PARSE_OK)
+            abort();
+    });
+    run_process("file mmap reference", bytes, [&] {
+        lept_document d;
+        if (d.lept_parse_file(path, LEPT_FILE_REFERENCE) != LEPT_PARSE_OK)
+            abort();
+    });
+    unlink(path);
+}
+#endif
+
+/** 约 50KB 的对象，50 个字段，每个字段是一组记录 */
+std::string make_wide_object()
+{
+    std::string json = "{";
+    for (int i = 0; i < 50; i++)
+    {
+        char key[32];
+        snprintf(key, sizeof(key), "%s\"field_%d\":", i ? "," : "", i);
+        json += key + make_records(8);
+    }
+    json += "}";
+    return json;
+}
+
+/** 从大文档中只读取少数字段：按需访问与完整解析后查找的对比 */
+void bench_lazy(int rounds)
+{
+    std::string json = make_wide_object();
+    static const char *fields[][4] = {{"field_0", "field_1", "field_2", "field_3"},
+                                      {"field_10", "field_20", "field_30", "field_49"}};
+    static const char *names[][2] = {{"dom 4 leading fields", "lazy 4 leading fields"},
+                                     {"dom 4 spread fields", "lazy 4 spread fields"}};
+    for (int f = 0; f < 2; f++)
+    {
+        lept_document d;
+        lept_value v;
+        run(names[f][0], rounds, json.size(), [&] {
+            if (d.lept_parse(json) != LEPT_PARSE_OK)
+                abort();
+            for (const char *k : fields[f])
+                v = *d.lept_get_root().lept_find_object_value(k)->lept_array_at(3).lept_find_object_value("name");
+        });
+        run(names[f][1], rounds, json.size(), [&] {
+            lept_lazy_value doc = lept_lazy_value::lept_parse(json.data(), json.size());
+            for (const char *k : fields[f])
+                if (doc.lept_find_object_value(k).lept_array_at(3).lept_find_object_value("name").lept_get_value(v) !=
+                    LEPT_PARSE_OK)
+                    abort();
+        });
+    }
+}
+
+/** 递归下降与结构索引两个引擎的对比 */
+void bench_engine(const char *name, const std::string &json, int rounds)
+{
+    static const char *engines[] = {"descent", "indexed"};
+    lept_document d;
+    for (int e = LEPT_ENGINE_DESCENT; e <= LEPT_ENGINE_INDEXED; e++)
+    {
+        lept_parse_options options;
+        options.engine = (lept_engine)e;
+        d.lept_set_options(options);
+        std::string label = std::string(engines[e]) + " " + name;
+        run(label.c_str(), rounds, json.size(), [&] {
+            if (d.lept_parse(json) != LEPT_PARSE_OK)
+                abort();
+        });
+    }
+}
+
+/** 缩进排版后的 json，记号之间多是空白 */
+std::string make_pretty(const std::string &json)
+{
+    lept_value v;
+    lept_buffer b;
+    if (lept_value::lept_parse(v, json) != LEPT_PARSE_OK)
+        abort();
+    lept_value::lept_stringify(v, b, LEPT_STRINGIFY_PRETTY);
+    return std::string(b.lept_get_data(), b.lept_get_size());
+}
+
+/** 由 n 条记录组成的 NDJSON，每行一条 */
+std::string make_lines(int n)
+{
+    std::string json = make_records(n);
+    std::string lines;
+    lines.reserve(json.size());
+    int depth = 0;
+    for (size_t i = 1; i + 1 < json.size(); i++) // 去掉外层的 '[' 与 ']'，顶层的 ',' 换成换行
+    {
+        char ch = json[i];
+        depth += ch == '{' || ch == '[' ? 1 : ch == '}' || ch == ']' ? -1 : 0;
+        lines += depth == 0 && ch == ',' ? '\n' : ch;
+    }
+    lines += '\n';
+    return lines;
+}
+
+/** NDJSON 逐行单线程解析与批量解析在 1 到 N 个线程下的对比 */
+void bench_batch(int n, int rounds)
+{
+    std::string lines = make_lines(n);
+    lept_value v;
+    run("ndjson per line", rounds, lines.size(), [&] {
+        for (size_t p = 0, eol; p < lines.size(); p = eol + 1)
+        {
+            eol = lines.find('\n', p);
+            if (lept_value::lept_parse(v, lines.c_str() + p, eol - p) != LEPT_PARSE_OK)
+                abort();
+        }
+    });
+    unsigned max = std::thread::hardware_concurrency();
+    std::vector<unsigned> counts; // 1, 2, 4, ..., 硬件线程数
+    for (unsigned threads = 1; threads < max; threads *= 2)
+        counts.push_back(threads);
+    counts.push_back(std::max(max, 1u));
+    for (unsigned threads : counts)
+    {
+        lept_batch batch(threads);
+        std::string label = "ndjson batch x" + std::to_string(threads);
+        run(label.c_str(), rounds, lines.size(), [&] {
+            if (batch.lept_parse_lines(lines) != (size_t)n)
+                abort();
+        });
+    }
+}
+
+/** 从每条记录中取出 /pos/x 与 /tags/1：逐层拷贝、编译后的路径、直接在文本上求值的对比 */
+void bench_path(int n, int rounds)
+{
+    std::string lines = make_lines(n);
+    std::vector<std::pair<size_t, size_t>> records; // 各行的起止位置
+    for (size_t p = 0, eol; p < lines.size(); p = eol + 1)
+    {
+        eol = lines.find('\n', p);
+        records.push_back(std::make_pair(p, eol));
+    }
+
+    lept_value v, pos, x, tags, k_pos, k_x, k_tags;
+    k_pos.lept_set_string("pos");
+    k_x.lept_set_string("x");
+    k_tags.lept_set_string("tags");
+    double sum = 0;
+    run("path chained copies", rounds, lines.size(), [&] {
+        for (auto &r : records)
+        {
+            if (lept_value::lept_parse(v, lines.c_str() + r.first, r.second - r.first) != LEPT_PARSE_OK)
+                abort();
+            sum += v.lept_get_object_value(k_pos).lept_get_object_value(k_x).lept_get_number();
+            sum += v.lept_get_object_value(k_tags).lept_get_array_element(1).lept_get_string_length();
+        }
+    });
+
+    lept_path path_x, path_tag;
+    path_x.lept_compile("/pos/x");
+    path_tag.lept_compile("/tags/1");
+    run("path compiled dom", rounds, lines.size(), [&] {
+        for (auto &r : records)
+        {
+            if (lept_value::lept_parse(v, lines.c_str() + r.first, r.second - r.first) != LEPT_PARSE_OK)
+                abort();
+            sum += path_x.lept_find(v)->lept_get_number() + path_tag.lept_find(v)->lept_get_string_length();
+        }
+    });
+    run("path compiled raw", rounds, lines.size(), [&] {
+        for (auto &r : records)
+        {
+            const char *json = lines.c_str() + r.first;
+            if (path_x.lept_find(json, r.second - r.first).lept_get_value(x) != LEPT_PARSE_OK ||
+                path_tag.lept_find(json, r.second - r.first).lept_get_value(tags) != LEPT_PARSE_OK)
+                abort();
+            sum += x.lept_get_number() + tags.lept_get_string_length();
+        }
+    });
+    if (sum != sum)
+        abort();
+}
+
+struct bench_pos
+{
+    int x, y;
+};
+
+struct bench_record
+{
+    int64_t id;
+    std::string name;
+    double score;
+    bool active;
+    std::vector<std::string> tags;
+    bench_pos pos;
+};
+
+LEPT_BIND_BEGIN(bench_pos)
+    LEPT_BIND_FIELD(x)
+    LEPT_BIND_FIELD(y)
+LEPT_BIND_END()
+
+LEPT_BIND_BEGIN(bench_record)
+    LEPT_BIND_FIELD(id)
+    LEPT_BIND_FIELD(name)
+    LEPT_BIND_FIELD(score)
+    LEPT_BIND_FIELD(active)
+    LEPT_BIND_FIELD(tags)
+    LEPT_BIND_FIELD(pos)
+LEPT_BIND_END()
+
+/** 记录数组解析为结构体：先解析成树再逐字段拷贝，与直接绑定的对比 */
+void bench_bind(const std::string &json, int rounds)
+{
+    lept_value v;
+    size_t count = 0;
+    run("bind via dom copy", rounds, json.size(), [&] {
+        std::vector<bench_record> records;
+        if (lept_value::lept_parse(v, json) != LEPT_PARSE_OK)
+            abort();
+        records.resize(v.lept_get_array_size());
+        for (size_t i = 0; i < records.size(); i++)
+        {
+            const lept_value &e = v.lept_array_at(i);
+            bench_record &r = records[i];
+            const lept_value *name = e.lept_find_object_value("name", 4), *tags = e.lept_find_object_value("tags", 4),
+                             *pos = e.lept_find_object_value("pos", 3);
+            r.id = e.lept_find_object_value("id", 2)->lept_get_int64();
+            r.name.assign(name->lept_get_string(), name->lept_get_string_length());
+            r.score = e.lept_find_object_value("score", 5)->lept_get_number();
+            r.active = e.lept_find_object_value("active", 6)->lept_get_boolean();
+            for (const lept_value *t = tags->lept_array_begin(); t != tags->lept_array_end(); t++)
+                r.tags.emplace_back(t->lept_get_string(), t->lept_get_string_length());
+            r.pos.x = (int)pos->lept_find_object_value("x", 1)->lept_get_int64();
+            r.pos.y = (int)pos->lept_find_object_value("y", 1)->lept_get_int64();
+        }
+        v = lept_value(); // 树与结构体同时存在，计入释放
+        count += records.size();
+    });
+    run("bind direct", rounds, json.size(), [&] {
+        std::vector<bench_record> records;
+        if (lept_parse_into(records, json.data(), json.size()) != LEPT_PARSE_OK)
+            abort();
+        count += records.size();
+    });
+    if (count == 0)
+        abort();
+}
+
+/** 顶层大数组的顺序解析与 1 到 N 个线程的并行解析 */
+void bench_parallel(const std::string &json, int rounds)
+{
+    lept_value v;
+    run("array serial", rounds, json.size(), [&] {
+        if (lept_value::lept_parse(v, json) != LEPT_PARSE_OK)
+            abort();
+    });
+    unsigned max = std::thread::hardware_concurrency();
+    std::vector<unsigned> counts; // 1, 2, 4, ..., 硬件线程数
+    for (unsigned threads = 1; threads < max; threads *= 2)
+        counts.push_back(threads);
+    counts.push_back(std::max(max, 2u)); // 至少测一次经过预扫描的路径
+    for (unsigned threads : counts)
+    {
+        std::string label = "array parallel x" + std::to_string(threads);
+        run(label.c_str(), rounds, json.size(), [&] {
+            if (lept_value::lept_parse_parallel(v, json.data(), json.size(), threads) != LEPT_PARSE_OK)
+                abort();
+        });
+        lept_document d; // 每个线程的 arena 跨轮次复用
+        label = "document parallel x" + std::to_string(threads);
+        run(label.c_str(), rounds, json.size(), [&] {
+            if (d.lept_parse_parallel(json, threads) != LEPT_PARSE_OK)
+                abort();
+        });
+    }
+}
+
+/** 序列化与往返（解析后再序列化）的吞吐量，输出缓冲复用 */
+void bench_stringify(const char *name, const std::string &json, int rounds)
+{
+    lept_document d;
+    lept_buffer b;
+    if (d.lept_parse(json.c_str()) != LEPT_PARSE_OK)
+        abort();
+    std::string label = std::string("stringify ") + name;
+    run(label.c_str(), rounds, json.size(), [&] {
+        b.lept_clear();
+        lept_value::lept_stringify(d.lept_get_root(), b);
+    });
+    label = std::string("roundtrip ") + name;
+    run(label.c_str(), rounds, json.size(), [&] {
+        if (d.lept_parse(json.c_str()) != LEPT_PARSE_OK)
+            abort();
+        b.lept_clear();
+        lept_value::lept_stringify(d.lept_get_root(), b);
+    });
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && strcmp(argv[1], "suite") == 0)
+        return bench_suite(argc - 2, argv + 2);
+    int n = argc > 1 ? atoi(argv[1]) : 100000;
+    std::string json = make_records(n);
+    printf("records: %d, size: %.1f MB\n", n, json.size() / 1e6);
+    bench_arena(json, 5);
+    bench_intern("records", json, 5);
+    bench_intern("wide", make_wide_records(n / 2), 5);
+    bench_stream(json, 5);
+    bench_events("records", json, 5);
+    bench_lazy(2000);
+    bench_path(n, 5);
+    bench_bind(json, 5);
+    bench_batch(n, 5);
+    bench_parallel(json, 5);
+    bench_engine("records", json, 5);
+    bench_engine("pretty", make_pretty(json), 5);
+    bench_engine("numbers", make_numbers(200000), 5);
+    bench_engine("strings", make_strings(20000), 5);
+#ifndef _WIN32
+    bench_file(n * 10);
+#endif
+    bench_events("numbers", make_numbers(200000), 5);
+    bench_events("strings", make_strings(20000), 5);
+    bench_nested(20);
+    bench_lookup();
+    bench_strings(10);
+    bench_numbers(10);
+    bench_stringify("records", json, 5);
+    bench_stringify("numbers", make_numbers(200000), 5);
+    bench_stringify("strings", make_strings(20000), 5);
+    return 0;
+}
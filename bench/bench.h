@@ -0,0 +1,9 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+extern std::atomic<size_t> alloc_count; // 自程序开始以来的堆分配次数，并行解析时各线程都会计入
+
+/** 在标准形状的语料上测量解析、遍历与序列化，参数为 "suite" 之后的命令行 */
+int bench_suite(int argc, char *argv[]);
@@ -0,0 +1,429 @@
+#include "bench.h"
+#include "leptjson.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+/*
+ * 标准语料上的测量
+ * 语料按 twitter.json、canada.json、citm_catalog.json 的结构生成，另有深层嵌套与以字符串为主的文档；
+ * 生成过程是确定的，不同版本之间的结果可以直接比较。
+ * 每种语料的每项操作在单独的子进程中运行，峰值常驻内存只包含这一项（以及语料本身）。
+ */
+
+/** 确定的伪随机数 */
+struct lcg
+{
+    uint32_t seed;
+
+    uint32_t next(uint32_t n)
+    {
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 8) % n;
+    }
+};
+
+/** 类似 twitter.json：推文与用户信息，键多、短字符串多，含非 ASCII 文本、\u 转义与转义的 '/' */
+std::string make_twitter(int n)
+{
+    static const char *texts[] = {
+        "@aym0566x \\n\\n名前:前田あゆみ\\n第一印象:なんか怖っ！\\n今の印象:とりあえずキモい。噛み合わない",
+        "RT @KATANA77: えっそれは・・・（一同） http:\\/\\/t.co\\/PkCJAcSuYK",
+        "\\u3053\\u3093\\u306b\\u3061\\u306f! Just landed in Tokyo \\ud83d\\ude00 #travel",
+        "Thanks for the \\\"great\\\" support, see https:\\/\\/example.com\\/status?id=42&lang=en",
+    };
+    lcg r = {1};
+    std::string json = "{\"statuses\":[";
+    char buf[1024];
+    for (int i = 0; i < n; i++)
+    {
+        uint64_t id = 505874924095815681ull + i * 7919;
+        snprintf(buf, sizeof(buf),
+                 "%s{\"metadata\":{\"result_type\":\"recent\",\"iso_language_code\":\"ja\"},"
+                 "\"created_at\":\"Sun Aug 31 00:29:%02d +0000 2014\",\"id\":%llu,\"id_str\":\"%llu\",\"text\":\"%s\","
+                 "\"source\":\"<a href=\\\"http:\\/\\/twitter.com\\/download\\/iphone\\\" rel=\\\"nofollow\\\">Twitter for "
+                 "iPhone<\\/a>\",\"truncated\":false,\"in_reply_to_status_id\":null,\"in_reply_to_user_id\":%s,",
+                 i ? "," : "", i % 60, (unsigned long long)id, (unsigned long long)id, texts[r.next(4)],
+                 i % 3 ? "null" : "1186275104");
+        json += buf;
+        snprintf(buf, sizeof(buf),
+                 "\"user\":{\"id\":%u,\"id_str\":\"%u\",\"name\":\"user %d\",\"screen_name\":\"screen_%d\","
+                 "\"location\":\"%s\",\"description\":\"%s\",\"url\":null,\"entities\":{\"description\":{\"urls\":[]}},"
+                 "\"protected\":false,\"followers_count\":%u,\"friends_count\":%u,\"listed_count\":%u,"
+                 "\"created_at\":\"Thu Jul 04 23:52:48 +0000 2013\",\"favourites_count\":%u,\"utc_offset\":null,"
+                 "\"time_zone\":null,\"geo_enabled\":%s,\"verified\":false,\"statuses_count\":%u,\"lang\":\"ja\","
+                 "\"profile_background_color\":\"C0DEED\",\"profile_image_url\":\"http:\\/\\/pbs.twimg.com\\/"
+                 "profile_images\\/%d\\/normal.jpeg\",\"default_profile\":true,\"following\":false},",
+                 1186275104u + i, 1186275104u + i, i, i, i % 2 ? "埼玉県" : "Tokyo, Japan", texts[r.next(4)],
+                 r.next(5000), r.next(1000), r.next(50), r.next(20000), i % 4 ? "true" : "false", r.next(100000), i);
+        json += buf;
+        snprintf(buf, sizeof(buf),
+                 "\"geo\":null,\"coordinates\":null,\"place\":null,\"contributors\":null,\"retweet_count\":%u,"
+                 "\"favorite_count\":%u,\"entities\":{\"hashtags\":[{\"text\":\"travel\",\"indices\":[%d,%d]}],"
+                 "\"symbols\":[],\"urls\":[{\"url\":\"http:\\/\\/t.co\\/PkCJAcSuYK\",\"expanded_url\":\"https:\\/\\/"
+                 "example.com\\/%d\",\"indices\":[24,46]}],\"user_mentions\":[{\"screen_name\":\"aym0566x\","
+                 "\"name\":\"前田あゆみ\",\"id\":586671909,\"id_str\":\"586671909\",\"indices\":[0,9]}]},"
+                 "\"favorited\":false,\"retweeted\":false,\"lang\":\"ja\"}",
+                 r.next(100), r.next(100), i % 30, i % 30 + 7, i);
+        json += buf;
+    }
+    snprintf(buf, sizeof(buf),
+             "],\"search_metadata\":{\"completed_in\":0.087,\"max_id\":505874924095815681,\"query\":\"%%E4%%B8%%80\","
+             "\"count\":%d,\"since_id\":0}}",
+             n);
+    json += buf;
+    return json;
+}
+
+/** 类似 canada.json：一个多边形的大量坐标，几乎全是 15 位有效数字的浮点数 */
+std::string make_canada(int rings, int points)
+{
+    lcg r = {2};
+    std::string json = "{\"type\":\"FeatureCollection\",\"features\":[{\"type\":\"Feature\",\"properties\":{\"name\":"
+                       "\"Canada\"},\"geometry\":{\"type\":\"Polygon\",\"coordinates\":[";
+    char buf[64];
+    for (int i = 0; i < rings; i++)
+    {
+        json += i ? ",[" : "[";
+        double x = -141.0 + r.next(8000) * 0.01, y = 42.0 + r.next(4000) * 0.01;
+        for (int j = 0; j < points; j++)
+        {
+            x += (r.next(2001) - 1000.0) * 1e-5 + 0.000000000000009;
+            y += (r.next(2001) - 1000.0) * 1e-5 + 0.000000000000007;
+            snprintf(buf, sizeof(buf), "%s[%.15f,%.15f]", j ? "," : "", x, y);
+            json += buf;
+        }
+        json += "]";
+    }
+    json += "]}}]}";
+    return json;
+}
+
+/** 类似 citm_catalog.json：以数字为键的大对象、嵌套的小对象与整数数组，null 很多 */
+std::string make_citm(int events, int performances)
+{
+    lcg r = {3};
+    std::string json = "{\"areaNames\":{";
+    char buf[512];
+    for (int i = 0; i < 20; i++)
+    {
+        snprintf(buf, sizeof(buf), "%s\"%d\":\"Arrière-scène %d\"", i ? "," : "", 205705993 + i, i);
+        json += buf;
+    }
+    json += "},\"audienceSubCategoryNames\":{\"337100890\":\"Abonné\"},\"blockNames\":{},\"events\":{";
+    for (int i = 0; i < events; i++)
+    {
+        int id = 138586341 + i * 4;
+        snprintf(buf, sizeof(buf),
+                 "%s\"%d\":{\"description\":null,\"id\":%d,\"logo\":%s,\"name\":\"Concert %d\",\"subTopicIds\":[%u,%u,"
+                 "%u],\"subjectCode\":null,\"subtitle\":null,\"topicIds\":[%u,%u]}",
+                 i ? "," : "", id, id, i % 3 ? "null" : "\"/images/UE0AAAAACEKo6QAAAAZDSVRN\"", i,
+                 337184262 + r.next(100), 337184283 + r.next(100), 337184275 + r.next(100), 324846099 + r.next(10),
+                 107888604 + r.next(10));
+        json += buf;
+    }
+    json += "},\"performances\":[";
+    for (int i = 0; i < performances; i++)
+    {
+        snprintf(buf, sizeof(buf), "%s{\"eventId\":%d,\"id\":%d,\"logo\":null,\"name\":null,\"prices\":[", i ? "," : "",
+                 138586341 + (int)r.next(events) * 4, 339887544 + i);
+        json += buf;
+        for (int p = 0; p < 4; p++)
+        {
+            snprintf(buf, sizeof(buf), "%s{\"amount\":%u,\"audienceSubCategoryId\":337100890,\"seatCategoryId\":%d}",
+                     p ? "," : "", 10000 + r.next(80) * 1000, 338937295 + p);
+            json += buf;
+        }
+        json += "],\"seatCategories\":[";
+        for (int s = 0; s < 4; s++)
+        {
+            json += s ? ",{\"areas\":[" : "{\"areas\":[";
+            for (int a = 0; a < 8; a++)
+            {
+                snprintf(buf, sizeof(buf), "%s{\"areaId\":%d,\"blockIds\":[]}", a ? "," : "", 205705993 + a + s);
+                json += buf;
+            }
+            snprintf(buf, sizeof(buf), "],\"seatCategoryId\":%d}", 338937295 + s);
+            json += buf;
+        }
+        snprintf(buf, sizeof(buf), "],\"seatMapImage\":null,\"start\":%llu,\"venueCode\":\"PLEYEL_PLEYEL\"}",
+                 1372616000000ull + i * 86400000ull);
+        json += buf;
+    }
+    json += "],\"seatCategoryNames\":{\"338937295\":\"1ère catégorie\"},\"subTopicNames\":{\"337184262\":\"Musique "
+            "amplifiée\"},\"subjectNames\":{},\"topicNames\":{\"107888604\":\"Activité\"},\"venueNames\":{"
+            "\"PLEYEL_PLEYEL\":\"Salle Pleyel\"}}";
+    return json;
+}
+
+/** 深层嵌套：数组与对象交替嵌套 depth 层 */
+std::string make_deep(int depth)
+{
+    std::string json;
+    for (int i = 0; i < depth; i++)
+        json += i % 2 ? "{\"k\":" : "[1,";
+    json += "\"leaf\"";
+    for (int i = depth - 1; i >= 0; i--)
+        json += i % 2 ? "}" : "]";
+    return json;
+}
+
+/** 以字符串为主：日志行（含各种转义）、UTF-8 文本与 base64 数据 */
+std::string make_text(int n)
+{
+    static const char b64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    lcg r = {5};
+    std::string json = "[";
+    for (int i = 0; i < n; i++)
+    {
+        json += i ? ",\"" : "\"";
+        json += "2026-10-17T12:00:00Z WARN [worker-" + std::to_string(i % 32) +
+                "]\\tquery=\\\"SELECT * FROM t WHERE path = 'C:\\\\\\\\tmp'\\\"\\n  caused by: timeout "
+                "\\u00e9\\u4e2d\\ud83d\\ude00 after " +
+                std::to_string(r.next(5000)) + "ms\",\"Größenordnung — 数据 ";
+        for (int j = 0; j < 256; j++)
+            json += b64[r.next(64)];
+        json += "\"";
+    }
+    json += "]";
+    return json;
+}
+
+/** 通过公开的访问函数遍历整棵树，返回节点数，内容累计到 sum 中以免被优化掉 */
+size_t walk(const lept_value &v, double &sum)
+{
+    switch (v.lept_get_type())
+    {
+    case LEPT_NUMBER:
+        sum += v.lept_get_number();
+        return 1;
+    case LEPT_STRING:
+        sum += v.lept_get_string_length();
+        return 1;
+    case LEPT_ARRAY: {
+        size_t n = 1;
+        for (const lept_value *e = v.lept_array_begin(); e != v.lept_array_end(); e++)
+            n += walk(*e, sum);
+        return n;
+    }
+    case LEPT_OBJECT: {
+        size_t n = 1;
+        for (const lept_member *m = v.lept_object_begin(); m != v.lept_object_end(); m++)
+        {
+            sum += m->k.lept_get_string_length();
+            n += walk(m->v, sum);
+        }
+        return n;
+    }
+    default:
+        return 1;
+    }
+}
+
+/** 与 walk 相同，但直接在 tape 上遍历，不还原出树 */
+size_t walk_tape(const lept_tape_value &v, double &sum)
+{
+    switch (v.lept_get_type())
+    {
+    case LEPT_NUMBER:
+        sum += v.lept_get_number();
+        return 1;
+    case LEPT_STRING:
+        sum += v.lept_get_string_length();
+        return 1;
+    case LEPT_ARRAY:
+    case LEPT_OBJECT: {
+        size_t n = 1;
+        for (lept_tape_value e = v.lept_get_first(); e.lept_is_valid(); e = e.lept_get_next())
+        {
+            sum += e.lept_get_key_length();
+            n += walk_tape(e, sum);
+        }
+        return n;
+    }
+    default:
+        return 1;
+    }
+}
+
+/** 一项测量的结果 */
+struct suite_result
+{
+    double rounds;
+    double ms;     // 每个文档的平均耗时
+    double allocs; // 每个文档的平均分配次数
+    long rss_kb;   // 子进程的峰值常驻内存，不可用时为 0
+};
+
+/** 反复执行 f，至少 3 次且累计至少 min_ms 毫秒 */
+template <typename F> suite_result suite_measure(double min_ms, F f)
+{
+    f(); // 预热
+    size_t allocs = alloc_count;
+    int rounds = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    double ms = 0;
+    while (rounds < 3 || ms < min_ms)
+    {
+        f();
+        rounds++;
+        ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    }
+    suite_result r = {(double)rounds, ms / rounds, (double)(alloc_count - allocs) / rounds, 0};
+    return r;
+}
+
+/**
+ * 执行一项操作：parse、document、walk、stringify，或二进制 tape 的 encode、decode 与 navigate。
+ * decode 还原出与 parse 相同的树；navigate 打开 tape 并像 walk 一样访问每个值，对应 parse 加 walk
+ */
+suite_result suite_run(const std::string &op, const std::string &json, double min_ms)
+{
+    lept_parse_options options;
+    options.max_depth = 4000; // deep 语料超过默认的嵌套深度限制
+    lept_document d;
+    d.lept_set_options(options);
+    lept_buffer b, tape;
+    if (op != "parse" && op != "document" && d.lept_parse(json) != LEPT_PARSE_OK)
+        abort();
+    lept_value::lept_encode(d.lept_get_root(), tape);
+    if (op == "parse")
+        return suite_measure(min_ms, [&] {
+            lept_value v;
+            if (lept_value::lept_parse(v, json, options) != LEPT_PARSE_OK)
+                abort();
+        });
+    if (op == "document")
+        return suite_measure(min_ms, [&] {
+            if (d.lept_parse(json) != LEPT_PARSE_OK)
+                abort();
+        });
+    if (op == "walk")
+        return suite_measure(min_ms, [&] {
+            double sum = 0;
+            if (walk(d.lept_get_root(), sum) == 0 || sum != sum)
+                abort();
+        });
+    if (op == "encode")
+        return suite_measure(min_ms, [&] {
+            b.lept_clear();
+            lept_value::lept_encode(d.lept_get_root(), b);
+        });
+    if (op == "decode")
+        return suite_measure(min_ms, [&] {
+            lept_value v;
+            if (lept_value::lept_decode(v, tape.lept_get_data(), tape.lept_get_size(), options) != LEPT_PARSE_OK)
+                abort();
+        });
+    if (op == "navigate")
+        return suite_measure(min_ms, [&] {
+            double sum = 0;
+            lept_tape_value root = lept_tape_value::lept_open(tape.lept_get_data(), tape.lept_get_size());
+            if (walk_tape(root, sum) == 0 || sum != sum)
+                abort();
+        });
+    return suite_measure(min_ms, [&] {
+        b.lept_clear();
+        lept_value::lept_stringify(d.lept_get_root(), b);
+    });
+}
+
+/** 在子进程中执行一项操作并取得其峰值常驻内存；Windows 上直接执行 */
+suite_result suite_run_isolated(const std::string &op, const std::string &json, double min_ms)
+{
+#ifdef _WIN32
+    return suite_run(op, json, min_ms);
+#else
+    int fds[2];
+    if (pipe(fds) != 0)
+        abort();
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        close(fds[0]);
+        suite_result r = suite_run(op, json, min_ms);
+        _exit(write(fds[1], &r, sizeof(r)) == (ssize_t)sizeof(r) ? 0 : 1);
+    }
+    close(fds[1]);
+    suite_result r;
+    bool ok = read(fds[0], &r, sizeof(r)) == (ssize_t)sizeof(r);
+    close(fds[0]);
+    int status;
+    struct rusage ru;
+    if (pid < 0 || wait4(pid, &status, 0, &ru) != pid || !ok)
+        abort();
+    r.rss_kb = ru.ru_maxrss; // Linux 上单位为 KB
+    return r;
+#endif
+}
+
+/**
+ * bench suite [--json] [--min-ms=N] [语料名...]
+ * 默认输出对齐的表格；--json 时每项测量输出一行 json（JSON Lines），便于保存与比较
+ */
+int bench_suite(int argc, char *argv[])
+{
+    static const char *simd_names[] = {"none", "sse2", "avx2"};
+    bool json_lines = false;
+    double min_ms = 300;
+    std::vector<std::string> only;
+    for (int i = 0; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--json") == 0)
+            json_lines = true;
+        else if (strncmp(argv[i], "--min-ms=", 9) == 0)
+            min_ms = atof(argv[i] + 9);
+        else
+            only.push_back(argv[i]);
+    }
+
+    struct
+    {
+        const char *name;
+        std::string (*make)();
+    } corpora[] = {
+        {"twitter", [] { return make_twitter(400); }},
+        {"canada", [] { return make_canada(480, 117); }},
+        {"citm", [] { return make_citm(184, 900); }},
+        {"deep", [] { return make_deep(4000); }},
+        {"strings", [] { return make_text(2000); }},
+    };
+    static const char *ops[] = {"parse", "document", "walk", "stringify", "encode", "decode", "navigate"};
+
+    if (!json_lines)
+        printf("%-10s %-10s %10s %10s %10s %10s %12s %12s\n", "corpus", "op", "KB", "ms/doc", "MB/s", "docs/s",
+               "allocs/doc", "peak RSS KB");
+    for (auto &corpus : corpora)
+    {
+        if (!only.empty() && std::find(only.begin(), only.end(), corpus.name) == only.end())
+            continue;
+        std::string json = corpus.make();
+        for (const char *op : ops)
+        {
+            suite_result r = suite_run_isolated(op, json, min_ms);
+            double mbs = json.size() / r.ms / 1e3, docs = 1e3 / r.ms;
+            if (json_lines)
+                printf("{\"corpus\":\"%s\",\"op\":\"%s\",\"bytes\":%zu,\"simd\":\"%s\",\"rounds\":%.0f,"
+                       "\"ms_per_doc\":%.6f,\"mb_per_s\":%.3f,\"docs_per_s\":%.3f,\"allocs_per_doc\":%.1f,"
+                       "\"peak_rss_kb\":%ld}\n",
+                       corpus.name, op, json.size(), simd_names[lept_get_simd_level()], r.rounds, r.ms, mbs, docs,
+                       r.allocs, r.rss_kb);
+            else
+                printf("%-10s %-10s %10.1f %10.3f %10.1f %10.1f %12.1f %12ld\n", corpus.name, op,
+                       json.size() / 1024.0, r.ms, mbs, docs, r.allocs, r.rss_kb);
+            fflush(stdout);
+        }
+    }
+    return 0;
+}
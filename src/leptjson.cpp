@@ -1,56 +1,65 @@
 #include "leptjson.h"
+#include "leptjson_internal.h"
 #include <cassert>
-#include <cerrno>
 #include <cmath>
 #include <cstdint>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <vector>
 
-struct lept_context // 解析上下文
+/** p 处的字符，到达末尾时为 '\0' */
+char lept_peek(const lept_reader &c, const char *p)
 {
-    const char *json; // 当前解析json所指向的部分
-};
+    return p < c.end ? *p : '\0';
+}
 
 /* ws = *(%x20 / %x09 / %x0A / %x0D) */
 /** 吃掉空白符 */
-void lept_parse_whitespace(lept_context &c)
+void lept_parse_whitespace(lept_reader &c)
 {
     const char *p = c.json;
-    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
+    while (p < c.end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
         p++;
     c.json = p;
 }
 
+/** 当前位置是否为长度为 n 的字面量 literal */
+bool lept_match_literal(const lept_reader &c, const char *literal, size_t n)
+{
+    return (size_t)(c.end - c.json) >= n && memcmp(c.json, literal, n) == 0;
+}
+
 /** 解析字面量 null / false / true */
-lept_parse_ret lept_parse_literal(lept_context &c, lept_value &v)
+lept_parse_ret lept_parse_literal(lept_reader &c, lept_value &v)
 {
     switch (*c.json)
     {
     case 'n': /* null  = "null" */
-        if (c.json[1] != 'u' || c.json[2] != 'l' || c.json[3] != 'l')
+        if (!lept_match_literal(c, "null", 4))
         {
             return LEPT_PARSE_INVALID_VALUE;
         }
         c.json += 4;
-        v.type = LEPT_NULL;
+        v.lept_free();
         return LEPT_PARSE_OK;
 
     case 'f': /* false = "false" */
-        if (c.json[1] != 'a' || c.json[2] != 'l' || c.json[3] != 's' || c.json[4] != 'e')
+        if (!lept_match_literal(c, "false", 5))
         {
             return LEPT_PARSE_INVALID_VALUE;
         }
         c.json += 5;
-        v.type = LEPT_FALSE;
-        v.b = false;
+        v.lept_set_boolean(false);
         return LEPT_PARSE_OK;
 
     case 't': /* true  = "true" */
-        if (c.json[1] != 'r' || c.json[2] != 'u' || c.json[3] != 'e')
+        if (!lept_match_literal(c, "true", 4))
         {
             return LEPT_PARSE_INVALID_VALUE;
         }
         c.json += 4;
-        v.type = LEPT_TRUE;
-        v.b = true;
+        v.lept_set_boolean(true);
         return LEPT_PARSE_OK;
 
     default:
@@ -58,53 +67,147 @@ lept_parse_ret lept_parse_literal(lept_context &c, lept_value &v)
     }
 }
 
-/** 解析数字 */
-lept_parse_ret lept_parse_number(lept_context &c, lept_value &v)
+/** 可由 double 精确表示的 10 的幂 */
+const double lept_exact_pow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                   1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+/*
+ * number = [ "-" ] int [ frac ] [ exp ]
+ * int = "0" / digit1-9 *digit
+ * frac = "." 1*digit
+ * exp = ("e" / "E") ["-" / "+"] 1*digit
+ */
+/** 解析数字，校验语法的同时累积有效数字与十进制指数，一遍完成；没有小数与指数部分的整数以 64 位整数精确保存 */
+lept_parse_ret lept_parse_number(lept_reader &c, lept_value &v)
 {
+    LEPT_STATS_TIME(number_ns);
     auto ISDIGIT = [=](char ch) { return ch >= '0' && ch <= '9'; };
     auto ISDIGIT1TO9 = [=](char ch) { return ch >= '1' && ch <= '9'; };
+    auto FITS = [=](uint64_t w, char ch) { // w * 10 + ch 不超过 UINT64_MAX
+        return w < 1844674407370955161u || (w == 1844674407370955161u && ch <= '5');
+    };
 
     const char *p = c.json;
-    if (*p == '-')
+    bool neg = false;
+    uint64_t w = 0;         // 有效数字
+    int e10 = 0;            // 十进制指数
+    bool full = false;      // w 是否已放不下更多数字
+    bool truncated = false; // 是否舍弃了非零的有效数字
+    bool integer = true;    // 是否没有小数与指数部分
+
+    if (lept_peek(c, p) == '-')
+    {
+        neg = true;
         p++;
-    if (*p == '0')
+    }
+    if (lept_peek(c, p) == '0')
         p++;
     else
     {
-        if (!ISDIGIT1TO9(*p))
+        if (!ISDIGIT1TO9(lept_peek(c, p)))
             return LEPT_PARSE_INVALID_VALUE;
-        for (p++; ISDIGIT(*p); p++)
-            ;
+        for (; ISDIGIT(lept_peek(c, p)); p++)
+        {
+            if (!full && FITS(w, *p))
+                w = w * 10 + (*p - '0');
+            else
+            {
+                full = true;
+                e10++; // 舍弃整数部分的低位
+                truncated |= *p != '0';
+            }
+        }
     }
-    if (*p == '.')
+    if (lept_peek(c, p) == '.')
     {
         p++;
-        if (!ISDIGIT(*p))
+        integer = false;
+        if (!ISDIGIT(lept_peek(c, p)))
             return LEPT_PARSE_INVALID_VALUE;
-        for (p++; ISDIGIT(*p); p++)
-            ;
+        for (; ISDIGIT(lept_peek(c, p)); p++)
+        {
+            if (!full && FITS(w, *p))
+            {
+                w = w * 10 + (*p - '0');
+                e10--;
+            }
+            else
+            {
+                full = true;
+                truncated |= *p != '0';
+            }
+        }
     }
-    if (*p == 'e' || *p == 'E')
+    if (lept_peek(c, p) == 'e' || lept_peek(c, p) == 'E')
     {
         p++;
-        if (*p == '+' || *p == '-')
-            p++;
-        if (!ISDIGIT(*p))
+        integer = false;
+        bool eneg = false;
+        if (lept_peek(c, p) == '+' || lept_peek(c, p) == '-')
+            eneg = *p++ == '-';
+        if (!ISDIGIT(lept_peek(c, p)))
             return LEPT_PARSE_INVALID_VALUE;
-        for (p++; ISDIGIT(*p); p++)
-            ;
+        int e = 0;
+        for (; ISDIGIT(lept_peek(c, p)); p++)
+            if (e < 100000) // 再大也只会上溢或下溢，避免 int 溢出
+                e = e * 10 + (*p - '0');
+        e10 += eneg ? -e : e;
     }
-    errno = 0;
-    v.n = strtod(c.json, NULL);
-    if (errno == ERANGE && (v.n == HUGE_VAL || v.n == -HUGE_VAL))
-        return LEPT_PARSE_NUMBER_TOO_BIG;
-    v.type = LEPT_NUMBER;
+    const char *begin = c.json;
     c.json = p;
+
+    if (integer && e10 == 0 && !(neg && w == 0)) // -0 按 double 保存以保留符号
+    {
+        if (!neg)
+        {
+            v.lept_set_uint64(w); // 不超过 INT64_MAX 的以 int64_t 保存
+            return LEPT_PARSE_OK;
+        }
+        if (w <= (uint64_t)INT64_MAX + 1)
+        {
+            v.lept_set_int64(w == (uint64_t)INT64_MAX + 1 ? INT64_MIN : -(int64_t)w);
+            return LEPT_PARSE_OK;
+        }
+    }
+
+    double n;
+    if (w == 0)
+        n = neg ? -0.0 : 0.0;
+    else if (e10 > 310) // w 不超过 20 位，结果必然超过 DBL_MAX
+        return LEPT_PARSE_NUMBER_TOO_BIG;
+    else if (e10 < -400) // 结果必然小于最小的次正规数的一半
+        n = neg ? -0.0 : 0.0;
+    else if (!truncated && w <= ((uint64_t)1 << 53) && e10 >= -22 && e10 <= 22)
+    { // w 与 10^|e10| 都能精确表示，一次乘除即得到正确舍入的结果
+        n = (double)w;
+        n = e10 < 0 ? n / lept_exact_pow10[-e10] : n * lept_exact_pow10[e10];
+        if (neg)
+            n = -n;
+    }
+    else
+    {
+        double n1;
+        bool ok = lept_eisel_lemire(w, e10, neg, n);
+        if (ok && truncated) // 真实值介于 w 与 w + 1 之间，两者结果相同时才能确定
+            ok = w != UINT64_MAX && lept_eisel_lemire(w + 1, e10, neg, n1) && n == n1;
+        if (!ok)
+        { // 极少发生，交给与区域设置无关的 strtod，数字复制出来以 '\0' 结尾
+            c.chars.assign(begin, p);
+            c.chars.push_back('\0');
+            n = lept_strtod_c(c.chars.data());
+        }
+        if (n == HUGE_VAL || n == -HUGE_VAL)
+            return LEPT_PARSE_NUMBER_TOO_BIG;
+    }
+
+    v.lept_set_number(n);
     return LEPT_PARSE_OK;
 }
 
-const char *lept_parse_hex4(const char *p, uint32_t &u)
+const char *lept_parse_hex4(const char *p, const char *end, uint32_t &u)
 {
+    if (end - p < 4)
+        return NULL;
     u = 0;
     for (int i = 0; i < 4; i++)
     {
@@ -122,344 +225,1433 @@ const char *lept_parse_hex4(const char *p, uint32_t &u)
     return p;
 }
 
-void lept_encode_utf8(std::vector<char> &c, uint32_t u)
+/** 将码点 u 以 UTF-8 写入 out，out 移到写入的末尾 */
+void lept_encode_utf8(char *&out, uint32_t u)
 {
     if (u <= 0x7f)
     {
         uint8_t x = 0;
         x |= u;
-        c.push_back(x);
+        *out++ = x;
     }
     else if (u <= 0x7ff)
     {
         uint8_t x = 0b11000000;
         x |= u >> 6;
-        c.push_back(x);
+        *out++ = x;
 
         x = 0b10000000;
         x |= u & 0b00000111111;
-        c.push_back(x);
+        *out++ = x;
     }
     else if (u <= 0xffff)
     {
         uint8_t x = 0b11100000;
         x |= u >> 12;
-        c.push_back(x);
+        *out++ = x;
 
         x = 0b10000000;
         x |= (u >> 6) & 0b0000111111;
-        c.push_back(x);
+        *out++ = x;
 
         x = 0b10000000;
         x |= u & 0b0000000000111111;
-        c.push_back(x);
+        *out++ = x;
     }
     else if (u <= 0x10ffff)
     {
         uint8_t x = 0b11110000;
         x |= u >> 18;
-        c.push_back(x);
+        *out++ = x;
 
         x = 0b10000000;
         x |= (u >> 12) & 0b000111111;
-        c.push_back(x);
+        *out++ = x;
 
         x = 0b10000000;
         x |= (u >> 6) & 0b000000000111111;
-        c.push_back(x);
+        *out++ = x;
 
         x = 0b10000000;
         x |= u & 0b000000000000000111111;
-        c.push_back(x);
+        *out++ = x;
     }
 }
 
-/** 解析字符串 */
-lept_parse_ret lept_parse_string(lept_context &c, lept_value &v)
+/** 分配 n 个字节的存储，arena 为 NULL 时从堆上分配 */
+void *lept_alloc(lept_arena *arena, size_t n)
 {
-    const char *p = c.json;
-    std::vector<char> res;
+    if (!arena)
+        LEPT_STATS_ADD(allocs, 1);
+    return arena ? arena->lept_alloc(n) : ::operator new(n);
+}
 
-    assert(*p == '"');
-    p++;
-    while (true)
-    {
-        switch (*p)
-        {
-        case '\\':
-            p++;
-            switch (*p++)
-            {
-            case '"':
-                res.push_back('\"');
-                break;
-            case '\\':
-                res.push_back('\\');
-                break;
-            case '/':
-                res.push_back('/');
-                break;
-            case 'b':
-                res.push_back('\b');
-                break;
-            case 'f':
-                res.push_back('\f');
-                break;
-            case 'n':
-                res.push_back('\n');
-                break;
-            case 'r':
-                res.push_back('\r');
-                break;
-            case 't':
-                res.push_back('\t');
-                break;
-            case 'u': {
-                uint32_t u = 0;
-                if (!(p = lept_parse_hex4(p, u)))
-                    return LEPT_PARSE_INVALID_UNICODE_HEX;
-                if (u >= 0xD800 && u <= 0xDBFF)
-                { // surrogate pair
-                    if (*p++ != '\\')
-                        return LEPT_PARSE_INVALID_UNICODE_SURROGATE;
-                    if (*p++ != 'u')
-                        return LEPT_PARSE_INVALID_UNICODE_SURROGATE;
-                    uint32_t u2 = 0;
-                    if (!(p = lept_parse_hex4(p, u2)))
-                        return LEPT_PARSE_INVALID_UNICODE_HEX;
-                    if (u2 < 0xDC00 || u2 > 0xDFFF)
-                        return LEPT_PARSE_INVALID_UNICODE_SURROGATE;
-                    u = (((u - 0xD800) << 10) | (u2 - 0xDC00)) + 0x10000;
-                }
-                lept_encode_utf8(res, u);
-                break;
-            }
-            default:
-                return LEPT_PARSE_INVALID_STRING_ESCAPE;
-            }
-            break;
-        case '"':
-            c.json = ++p;
-            res.push_back('\0');
-            v.s = res;
-            v.type = LEPT_STRING;
-            return LEPT_PARSE_OK;
-        case '\0':
-            return LEPT_PARSE_MISS_QUOTATION_MARK;
-        default:
-            if ((unsigned char)*p < 0x20)
-            {
-                return LEPT_PARSE_INVALID_STRING_CHAR;
-            }
-            res.push_back(*p++);
-        }
-    }
+/** 释放从堆上分配的存储 */
+void lept_dealloc(void *p)
+{
+    ::operator delete(p);
 }
 
-lept_parse_ret lept_parse_value(lept_context &c, lept_value &v); // 前向声明
-/** 解析数组 */
-lept_parse_ret lept_parse_array(lept_context &c, lept_value &v)
+/** 设置 v 的内容，arena 非空时标记为不持有内容 */
+void lept_set_payload(lept_value &v, lept_arena *arena, lept_type type, uint32_t size)
 {
-    assert(*c.json == '[');
-    c.json++;
-    lept_parse_whitespace(c);
-    if (*c.json == ']')
-    {
-        c.json++;
-        v = lept_value();
-        v.type = LEPT_ARRAY;
-        return LEPT_PARSE_OK;
-    }
+    v.lept_free();
+    v.size = size;
+    v.type = type;
+    v.flags = arena ? LEPT_FLAG_BORROWED : 0;
+}
 
-    while (true)
-    {
-        lept_value e;
-        lept_parse_ret ret;
+/** 将 v 置为长度为 len 的字符串，内容复制自 s */
+void lept_set_string_raw(lept_value &v, const char *s, size_t len, lept_arena *arena)
+{
+    assert(len <= UINT32_MAX);
+    char *d = (char *)lept_alloc(arena, len + 1);
+    if (len)
+        memcpy(d, s, len);
+    d[len] = '\0';
+    lept_set_payload(v, arena, LEPT_STRING, (uint32_t)len);
+    v.u.s = d;
+}
 
-        lept_parse_whitespace(c);
-        if ((ret = lept_parse_value(c, e)) != LEPT_PARSE_OK)
-            return ret;
-        v.a.push_back(e);
+/** 将 v 置为引用 s 的字符串 */
+void lept_set_string_ref(lept_value &v, char *s, size_t len)
+{
+    assert(len <= UINT32_MAX && s[len] == '\0');
+    v.lept_free();
+    v.size = (uint32_t)len;
+    v.type = LEPT_STRING;
+    v.flags = LEPT_FLAG_BORROWED;
+    v.u.s = s;
+}
 
-        lept_parse_whitespace(c);
-        if (*c.json == ',')
-        {
-            c.json++;
-        }
-        else if (*c.json == ']')
-        {
-            c.json++;
-            v.type = LEPT_ARRAY;
-            return LEPT_PARSE_OK;
-        }
-        else
-            return LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
-    }
+void lept_set_symbol(lept_value &v, char *s)
+{
+    lept_set_string_ref(v, s, ((lept_symbol_head *)s - 1)->len);
+    v.flags |= LEPT_FLAG_INTERNED;
+}
+
+/** 将 v 置为数组，元素从 e 中移动过来 */
+void lept_set_array_raw(lept_value &v, lept_value *e, size_t n, lept_arena *arena)
+{
+    assert(n <= UINT32_MAX);
+    lept_value *a = n ? (lept_value *)lept_alloc(arena, n * sizeof(lept_value)) : NULL;
+    for (size_t i = 0; i < n; i++)
+        new (&a[i]) lept_value(std::move(e[i]));
+    lept_set_payload(v, arena, LEPT_ARRAY, (uint32_t)n);
+    v.u.a = a;
+}
+
+/** 散列索引的槽，member 为成员下标加一，0 表示空槽 */
+struct lept_index_slot
+{
+    uint32_t member;
+    uint32_t hash;
+};
+
+uint32_t lept_hash_key(const char *k, size_t len)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++)
+        h = (h ^ (unsigned char)k[i]) * 16777619u;
+    return h;
+}
+
+/** 键 k 的散列值，驻留的键直接取出 */
+uint32_t lept_get_key_hash(const lept_value &k)
+{
+    if (k.flags & LEPT_FLAG_INTERNED)
+        return ((const lept_symbol_head *)k.u.s - 1)->hash;
+    return lept_hash_key(k.u.s, k.size);
+}
+
+/** 两个键是否相同，同一个符号表中驻留的键内容相同时指针也相同 */
+bool lept_key_equal(const lept_value &a, const char *k, size_t len)
+{
+    return a.size == len && (a.u.s == k || memcmp(a.u.s, k, len) == 0);
 }
 
-/** 解析对象 */
-lept_parse_ret lept_parse_object(lept_context &c, lept_value &v)
+char *lept_symbols::lept_find(const char *k, size_t len, uint32_t h) const
 {
-    assert(*c.json == '{');
-    c.json++;
-    lept_parse_whitespace(c);
-    if (*c.json == '}')
+    if (slots.empty())
+        return NULL;
+    size_t mask = slots.size() - 1;
+    for (size_t j = h & mask; slots[j]; j = (j + 1) & mask)
     {
-        c.json++;
-        v = lept_value();
-        v.type = LEPT_OBJECT;
-        return LEPT_PARSE_OK;
+        const lept_symbol_head *head = (const lept_symbol_head *)slots[j] - 1;
+        if (head->hash == h && head->len == len && memcmp(slots[j], k, len) == 0)
+            return slots[j];
     }
+    return NULL;
+}
 
-    lept_parse_ret ret = LEPT_PARSE_OK;
-    while (true)
+char *lept_symbols::lept_intern(const char *k, size_t len, lept_arena &arena)
+{
+    assert(len <= UINT32_MAX);
+    lept_symbol_head *prev = last ? (lept_symbol_head *)last - 1 : NULL;
+    if (char *s = prev ? prev->next : NULL)
+        if (((lept_symbol_head *)s - 1)->len == len && memcmp(s, k, len) == 0)
+            return last = s;
+
+    uint32_t h = lept_hash_key(k, len);
+    char *s = lept_find(k, len, h);
+    if (!s)
+        s = lept_insert(k, len, h, arena);
+    if (prev)
+        prev->next = s;
+    return last = s;
+}
+
+char *lept_symbols::lept_insert(const char *k, size_t len, uint32_t h, lept_arena &arena)
+{
+    if ((count + 1) * 2 > slots.size()) // 装载因子不超过 1/2
     {
-        lept_parse_whitespace(c);
-        if (*c.json != '"')
-            return LEPT_PARSE_MISS_KEY;
+        std::vector<char *> old(slots.size() ? slots.size() * 2 : 64, NULL);
+        old.swap(slots);
+        for (char *s : old)
+            if (s)
+            {
+                size_t j = ((lept_symbol_head *)s - 1)->hash & (slots.size() - 1);
+                while (slots[j])
+                    j = (j + 1) & (slots.size() - 1);
+                slots[j] = s;
+            }
+    }
+    lept_symbol_head *head = (lept_symbol_head *)arena.lept_alloc(sizeof(lept_symbol_head) + len + 1);
+    head->next = NULL;
+    head->len = (uint32_t)len;
+    head->hash = h;
+    char *s = (char *)(head + 1);
+    if (len)
+        memcpy(s, k, len);
+    s[len] = '\0';
+    size_t j = h & (slots.size() - 1);
+    while (slots[j])
+        j = (j + 1) & (slots.size() - 1);
+    slots[j] = s;
+    count++;
+    return s;
+}
 
-        lept_value k;
-        ret = lept_parse_string(c, k);
-        if (ret != LEPT_PARSE_OK)
-            break;
+void lept_symbols::lept_clear()
+{
+    slots.clear();
+    count = 0;
+    last = NULL;
+}
 
-        lept_parse_whitespace(c);
-        if (*c.json != ':')
-        {
-            ret = LEPT_PARSE_MISS_COLON;
-            break;
-        }
-        c.json++;
-        lept_parse_whitespace(c);
+/** 有 n 个成员、带有索引的对象的索引槽数 */
+size_t lept_index_capacity(size_t n)
+{
+    size_t cap = 1;
+    while (cap < n * 2) // 装载因子不超过 1/2
+        cap <<= 1;
+    return cap;
+}
 
-        lept_value kv;
-        ret = lept_parse_value(c, kv);
-        if (ret != LEPT_PARSE_OK)
-            break;
-        v.o.push_back({k, kv});
+/** 索引紧跟在成员数组之后，与其处于同一块存储中 */
+lept_index_slot *lept_get_index(lept_member *o, size_t n)
+{
+    return (lept_index_slot *)(o + n);
+}
+
+/** 为有 n 个成员的对象分配存储，indexed 时包括其索引 */
+lept_member *lept_alloc_members(lept_arena *arena, size_t n, bool indexed)
+{
+    assert(n <= UINT32_MAX);
+    if (!n)
+        return NULL;
+    size_t cap = indexed ? lept_index_capacity(n) : 0;
+    return (lept_member *)lept_alloc(arena, n * sizeof(lept_member) + cap * sizeof(lept_index_slot));
+}
 
-        lept_parse_whitespace(c);
-        if (*c.json == ',')
-            c.json++;
-        else if (*c.json == '}')
+/** 成员就位后建立索引（开放寻址，线性探测）；重复的键只索引第一个，与线性查找的结果一致 */
+void lept_build_index(lept_member *o, size_t n)
+{
+    size_t cap = lept_index_capacity(n);
+    lept_index_slot *slots = lept_get_index(o, n);
+    memset(slots, 0, cap * sizeof(lept_index_slot));
+    for (size_t i = 0; i < n; i++)
+    {
+        const lept_value &k = o[i].k;
+        uint32_t h = lept_get_key_hash(k);
+        size_t j = h & (cap - 1);
+        for (; slots[j].member; j = (j + 1) & (cap - 1))
+            if (slots[j].hash == h && lept_key_equal(o[slots[j].member - 1].k, k.u.s, k.size))
+                break;
+        if (!slots[j].member)
         {
-            c.json++;
-            break;
+            slots[j].member = (uint32_t)i + 1;
+            slots[j].hash = h;
         }
-        else
-            return LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
     }
+}
 
-    return ret;
+/** 有 n 个成员的对象是否按 index_min 建立索引 */
+bool lept_wants_index(size_t n, size_t index_min)
+{
+    return index_min && n >= index_min;
 }
 
-/* value = null / false / true / number / string / array / object */
-lept_parse_ret lept_parse_value(lept_context &c, lept_value &v)
+/** 将 v 置为对象，成员从 m 中移动过来 */
+void lept_set_object_raw(lept_value &v, lept_member *m, size_t n, lept_arena *arena, size_t index_min)
 {
-    switch (*c.json)
-    {
-    case 'n':
-    case 'f':
-    case 't':
-        return lept_parse_literal(c, v);
-    case '\0':
-        return LEPT_PARSE_EXPECT_VALUE;
-    case '"':
-        return lept_parse_string(c, v);
-    case '[':
-        return lept_parse_array(c, v);
-    case '{':
-        return lept_parse_object(c, v);
-    default:
-        return lept_parse_number(c, v);
-    }
+    bool indexed = lept_wants_index(n, index_min);
+    lept_member *o = lept_alloc_members(arena, n, indexed);
+    for (size_t i = 0; i < n; i++)
+        new (&o[i]) lept_member(std::move(m[i]));
+    if (indexed)
+        lept_build_index(o, n);
+    lept_set_payload(v, arena, LEPT_OBJECT, (uint32_t)n);
+    v.flags |= indexed ? LEPT_FLAG_INDEXED : 0;
+    v.u.o = o;
+}
+
+/** 将 v 置为对象，键和值交替存放在 kv 中，从中移动过来 */
+void lept_set_object_pairs(lept_value &v, lept_value *kv, size_t n, lept_arena *arena, size_t index_min)
+{
+    bool indexed = lept_wants_index(n, index_min);
+    lept_member *o = lept_alloc_members(arena, n, indexed);
+    for (size_t i = 0; i < n; i++)
+        new (&o[i]) lept_member{std::move(kv[i * 2]), std::move(kv[i * 2 + 1])};
+    if (indexed)
+        lept_build_index(o, n);
+    lept_set_payload(v, arena, LEPT_OBJECT, (uint32_t)n);
+    v.flags |= indexed ? LEPT_FLAG_INDEXED : 0;
+    v.u.o = o;
 }
 
 /************************************************************************************************ */
 
-lept_parse_ret lept_value::lept_parse(lept_value &v, const char *json)
+/** 找到 [p, end) 中第一个 '"'、'\\' 或控制字符，没有时返回 end */
+const char *lept_scan_string_scalar(const char *p, const char *end)
 {
-    lept_context c; // 定义一个上下文
-    c.json = json;
+    while (p < end && *p != '"' && *p != '\\' && (unsigned char)*p >= 0x20)
+        p++;
+    return p;
+}
 
-    lept_parse_whitespace(c);
-    lept_parse_ret ret = lept_parse_value(c, v);
-    if (ret == LEPT_PARSE_OK)
+#ifdef LEPT_X86_SIMD
+/* 向量版本每次比较一整块，不足一块的尾部逐字节处理，不会读取 end 之后的内容 */
+
+__attribute__((target("sse2"))) const char *lept_scan_string_sse2(const char *p, const char *end)
+{
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i escape = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+    for (; end - p >= 16; p += 16)
     {
-        lept_parse_whitespace(c);
-        if (*c.json != '\0')
-        {
-            ret = LEPT_PARSE_ROOT_NOT_SINGULAR;
-        }
+        __m128i x = _mm_loadu_si128((const __m128i *)p);
+        __m128i m = _mm_or_si128(_mm_cmpeq_epi8(x, quote), _mm_cmpeq_epi8(x, escape));
+        m = _mm_or_si128(m, _mm_cmpeq_epi8(_mm_min_epu8(x, control), x)); // x <= 0x1F
+        if (int mask = _mm_movemask_epi8(m))
+            return p + __builtin_ctz(mask);
     }
-    return ret;
+    return lept_scan_string_scalar(p, end);
 }
 
-lept_type lept_value::lept_get_type()
+__attribute__((target("avx2"))) const char *lept_scan_string_avx2(const char *p, const char *end)
 {
-    return this->type;
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i escape = _mm256_set1_epi8('\\');
+    const __m256i control = _mm256_set1_epi8(0x1F);
+    for (; end - p >= 32; p += 32)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)p);
+        __m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(x, quote), _mm256_cmpeq_epi8(x, escape));
+        m = _mm256_or_si256(m, _mm256_cmpeq_epi8(_mm256_min_epu8(x, control), x));
+        if (unsigned mask = (unsigned)_mm256_movemask_epi8(m))
+            return p + __builtin_ctz(mask);
+    }
+    return lept_scan_string_sse2(p, end);
 }
+#endif
 
-bool lept_value::lept_get_boolean()
+/** CPU 支持的最高 SIMD 级别 */
+lept_simd_level lept_detect_simd()
 {
-    assert(this->type == LEPT_TRUE || this->type == LEPT_FALSE);
-    return this->b;
+#ifdef LEPT_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return LEPT_SIMD_AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return LEPT_SIMD_SSE2;
+#endif
+    return LEPT_SIMD_NONE;
 }
 
-void lept_value::lept_set_boolean(bool b)
+std::atomic<lept_simd_level> lept_simd(LEPT_SIMD_NONE); // 当前使用的级别
+std::atomic<const char *(*)(const char *, const char *)> lept_scan_string_impl(lept_scan_string_scalar); // 按级别选择的实现
+lept_simd_level lept_simd_init = lept_set_simd_level(LEPT_SIMD_AVX2);   // 加载时选择最高可用级别
+
+lept_simd_level lept_get_simd_level()
 {
-    *this = lept_value();
-    this->type = b ? LEPT_TRUE : LEPT_FALSE;
-    this->b = b;
+    return lept_simd;
 }
 
-double lept_value::lept_get_number()
+lept_simd_level lept_set_simd_level(lept_simd_level level)
 {
-    assert(this->type == LEPT_NUMBER);
-    return this->n;
+    lept_simd_level max = lept_detect_simd();
+    level = level < max ? level : max;
+    switch (level)
+    {
+#ifdef LEPT_X86_SIMD
+    case LEPT_SIMD_AVX2:
+        lept_scan_string_impl = lept_scan_string_avx2;
+        lept_classify_block_impl = lept_classify_block_avx2;
+        lept_index_blocks_impl = lept_index_blocks_avx2;
+        break;
+    case LEPT_SIMD_SSE2:
+        lept_scan_string_impl = lept_scan_string_sse2;
+        lept_classify_block_impl = lept_classify_block_sse2;
+        lept_index_blocks_impl = lept_index_blocks_sse2;
+        break;
+#endif
+    default:
+        lept_scan_string_impl = lept_scan_string_scalar;
+        lept_classify_block_impl = lept_classify_block_scalar;
+        lept_index_blocks_impl = lept_index_blocks_scalar;
+    }
+    lept_simd = level;
+    return level;
 }
 
-void lept_value::lept_set_number(double n)
+/************************************************************************************************ */
+
+/** 解码 '\\' 之后从 p 开始的转义序列，结果写入 out（至多 4 个字节），成功时 p 与 out 都移到末尾 */
+lept_parse_ret lept_parse_escape(const lept_reader &c, const char *&p, char *&out)
 {
-    *this = lept_value();
-    this->type = LEPT_NUMBER;
-    this->n = n;
+    LEPT_STATS_ADD(escapes, 1);
+    switch (lept_peek(c, p++))
+    {
+    case '"':
+        *out++ = '\"';
+        break;
+    case '\\':
+        *out++ = '\\';
+        break;
+    case '/':
+        *out++ = '/';
+        break;
+    case 'b':
+        *out++ = '\b';
+        break;
+    case 'f':
+        *out++ = '\f';
+        break;
+    case 'n':
+        *out++ = '\n';
+        break;
+    case 'r':
+        *out++ = '\r';
+        break;
+    case 't':
+        *out++ = '\t';
+        break;
+    case 'u': {
+        uint32_t u = 0;
+        if (!(p = lept_parse_hex4(p, c.end, u)))
+            return LEPT_PARSE_INVALID_UNICODE_HEX;
+        if (u >= 0xD800 && u <= 0xDBFF)
+        { // surrogate pair
+            if (lept_peek(c, p++) != '\\')
+                return LEPT_PARSE_INVALID_UNICODE_SURROGATE;
+            if (lept_peek(c, p++) != 'u')
+                return LEPT_PARSE_INVALID_UNICODE_SURROGATE;
+            uint32_t u2 = 0;
+            if (!(p = lept_parse_hex4(p, c.end, u2)))
+                return LEPT_PARSE_INVALID_UNICODE_HEX;
+            if (u2 < 0xDC00 || u2 > 0xDFFF)
+                return LEPT_PARSE_INVALID_UNICODE_SURROGATE;
+            u = (((u - 0xD800) << 10) | (u2 - 0xDC00)) + 0x10000;
+        }
+        lept_encode_utf8(out, u);
+        break;
+    }
+    default:
+        return LEPT_PARSE_INVALID_STRING_ESCAPE;
+    }
+    return LEPT_PARSE_OK;
 }
 
-const char *lept_value::lept_get_string()
+/**
+ * 原地解析字符串：结果紧接在开头的 '"' 之后写回输入并以 '\0' 结尾
+ * 解码结果不会比原文长，写入位置总不超过读取位置
+ */
+lept_parse_ret lept_parse_string_insitu(lept_reader &c, const char *&s, size_t &len)
 {
-    assert(this->type == LEPT_STRING);
-    return this->s.data();
+    char *out = const_cast<char *>(c.json) + 1;
+    const char *p = out;
+    s = out;
+    while (true)
+    {
+        const char *q = lept_scan_string(p, c.end);
+        if (q == c.end)
+            return LEPT_PARSE_MISS_QUOTATION_MARK;
+        if (out != p) // 遇到过转义之后，普通字符要前移
+            memmove(out, p, q - p);
+        out += q - p;
+        switch (*q)
+        {
+        case '"':
+            c.json = q + 1;
+            len = out - s;
+            *out = '\0';
+            LEPT_STATS_ADD(string_bytes, len);
+            return LEPT_PARSE_OK;
+        case '\\': {
+            p = q + 1;
+            lept_parse_ret ret = lept_parse_escape(c, p, out);
+            if (ret != LEPT_PARSE_OK)
+                return ret;
+            break;
+        }
+        default:
+            return LEPT_PARSE_INVALID_STRING_CHAR;
+        }
+    }
 }
 
-void lept_value::lept_set_string(const char *s)
+/** 解析字符串，没有转义时 s 直接指向输入，否则指向解码到 c.chars 中的内容；原地解析时总是指向输入 */
+lept_parse_ret lept_parse_string_raw(lept_reader &c, const char *&s, size_t &len)
+{
+    LEPT_STATS_TIME(string_ns);
+    if (c.insitu)
+        return lept_parse_string_insitu(c, s, len);
+
+    const char *p = c.json;
+    std::vector<char> &res = c.chars;
+    res.clear();
+
+    assert(*p == '"');
+    p++;
+    while (true)
+    {
+        const char *q = lept_scan_string(p, c.end); // 普通字符成段跳过
+        if (q == c.end)
+            return LEPT_PARSE_MISS_QUOTATION_MARK;
+        switch (*q)
+        {
+        case '"':
+            c.json = q + 1;
+            if (res.empty()) // 没有遇到转义，直接引用输入
+            {
+                s = p;
+                len = q - p;
+            }
+            else
+            {
+                res.insert(res.end(), p, q);
+                s = res.data();
+                len = res.size();
+            }
+            LEPT_STATS_ADD(string_bytes, len);
+            return LEPT_PARSE_OK;
+        case '\\': {
+            res.insert(res.end(), p, q);
+            p = q + 1;
+            char buf[4], *out = buf;
+            lept_parse_ret ret = lept_parse_escape(c, p, out);
+            if (ret != LEPT_PARSE_OK)
+                return ret;
+            res.insert(res.end(), buf, out);
+            break;
+        }
+        default:
+            return LEPT_PARSE_INVALID_STRING_CHAR;
+        }
+    }
+}
+
+/************************************************************************************************ */
+
+/** 将字符串 s[0, len) 加上引号并转义后写入 b，无需转义的部分成段复制 */
+void lept_stringify_string(lept_buffer &b, const char *s, size_t len)
 {
-    *this = lept_value();
-    this->type = LEPT_STRING;
-    this->s.clear();
-    for (int i = 0;; i++)
+    static const char hex[] = "0123456789ABCDEF";
+    const char *end = s + len;
+
+    *b.lept_push(1) = '"';
+    while (true)
     {
-        this->s.push_back(s[i]);
-        if (s[i] == '\0')
+        const char *q = lept_scan_string(s, end);
+        if (q > s)
+            memcpy(b.lept_push(q - s), s, q - s);
+        if (q == end)
+            break;
+
+        char *p;
+        switch (*q)
+        {
+        case '"':
+        case '\\':
+            p = b.lept_push(2);
+            p[0] = '\\';
+            p[1] = *q;
+            break;
+        case '\b':
+            memcpy(b.lept_push(2), "\\b", 2);
+            break;
+        case '\f':
+            memcpy(b.lept_push(2), "\\f", 2);
             break;
+        case '\n':
+            memcpy(b.lept_push(2), "\\n", 2);
+            break;
+        case '\r':
+            memcpy(b.lept_push(2), "\\r", 2);
+            break;
+        case '\t':
+            memcpy(b.lept_push(2), "\\t", 2);
+            break;
+        default: // 其余控制字符
+            p = b.lept_push(6);
+            memcpy(p, "\\u00", 4);
+            p[4] = hex[(unsigned char)*q >> 4];
+            p[5] = hex[*q & 0xF];
+        }
+        s = q + 1;
     }
+    *b.lept_push(1) = '"';
 }
 
-lept_value lept_value::lept_get_array_element(std::vector<lept_value>::size_type index)
+/** 写入换行与 depth 层缩进 */
+void lept_stringify_indent(lept_buffer &b, size_t depth)
 {
-    assert(this->type == LEPT_ARRAY && index < this->a.size());
-    return this->a[index];
+    char *p = b.lept_push(1 + depth * 4);
+    *p++ = '\n';
+    memset(p, ' ', depth * 4);
+}
+
+/** 序列化数组与对象之外的值 */
+void lept_stringify_scalar(lept_buffer &b, const lept_value &v)
+{
+    switch (v.type)
+    {
+    case LEPT_NULL:
+        memcpy(b.lept_push(4), "null", 4);
+        break;
+    case LEPT_FALSE:
+        memcpy(b.lept_push(5), "false", 5);
+        break;
+    case LEPT_TRUE:
+        memcpy(b.lept_push(4), "true", 4);
+        break;
+    case LEPT_NUMBER: {
+        char *p = b.lept_push(32), *e;
+        if (v.flags & LEPT_FLAG_INT64)
+            e = lept_i64toa(v.u.i64, p);
+        else if (v.flags & LEPT_FLAG_UINT64)
+            e = lept_u64toa(v.u.u64, p);
+        else if (std::isfinite(v.u.n))
+            e = lept_dtoa(v.u.n, p);
+        else
+        { // json 无法表示 NaN 与无穷大
+            memcpy(p, "null", 4);
+            e = p + 4;
+        }
+        b.lept_pop(32 - (e - p));
+        break;
+    }
+    case LEPT_STRING:
+        lept_stringify_string(b, v.u.s, v.size);
+        break;
+    default:
+        break;
+    }
 }
 
-lept_value lept_value::lept_get_object_value(const lept_value &k)
+/** 序列化时尚未写完的数组或对象 */
+struct lept_stringify_frame
 {
-    assert(k.type == LEPT_STRING);
+    const lept_value *v;
+    uint32_t next; // 下一个要写的元素或成员
+};
 
-    for (const auto &kv : this->o)
+/** 序列化 root，pretty 时换行缩进；用显式的栈代替递归，栈的用量与嵌套深度无关 */
+void lept_stringify_value(lept_buffer &b, const lept_value &root, bool pretty)
+{
+    if (root.type != LEPT_ARRAY && root.type != LEPT_OBJECT)
+    {
+        lept_stringify_scalar(b, root);
+        return;
+    }
+    lept_walk_stack<lept_stringify_frame> stack;
+    stack.push_back(lept_stringify_frame{&root, 0});
+    *b.lept_push(1) = root.type == LEPT_ARRAY ? '[' : '{';
+    while (!stack.empty())
     {
-        if (kv.first.s == k.s)
-            return kv.second;
+        const lept_value *c = stack.back().v, *e = NULL;
+        uint32_t i = stack.back().next;
+        for (; i < c->size; i++) // 逐个写出 c 的元素或成员，遇到数组或对象时转而写它
+        {
+            if (i)
+                *b.lept_push(1) = ',';
+            if (pretty)
+                lept_stringify_indent(b, stack.size());
+            if (c->type == LEPT_ARRAY)
+                e = &c->u.a[i];
+            else
+            {
+                lept_stringify_string(b, c->u.o[i].k.u.s, c->u.o[i].k.size);
+                if (pretty)
+                    memcpy(b.lept_push(2), ": ", 2);
+                else
+                    *b.lept_push(1) = ':';
+                e = &c->u.o[i].v;
+            }
+            if (e->type == LEPT_ARRAY || e->type == LEPT_OBJECT)
+                break;
+            lept_stringify_scalar(b, *e);
+        }
+        if (i < c->size)
+        {
+            *b.lept_push(1) = e->type == LEPT_ARRAY ? '[' : '{';
+            stack.back().next = i + 1;
+            stack.push_back(lept_stringify_frame{e, 0});
+            continue;
+        }
+        stack.pop_back(); // c 已写完
+        if (pretty && c->size)
+            lept_stringify_indent(b, stack.size());
+        *b.lept_push(1) = c->type == LEPT_ARRAY ? ']' : '}';
     }
+}
+
+/************************************************************************************************ */
+
 
-    return lept_value();
+lept_parse_stats::lept_parse_stats()
+{
+    memset(this, 0, sizeof(*this));
+}
+
+uint64_t lept_parse_stats::lept_get_container_ns() const
+{
+    uint64_t tokens = string_ns + number_ns;
+    return total_ns > tokens ? total_ns - tokens : 0;
+}
+
+void lept_parse_stats::lept_add(const lept_parse_stats &rhs)
+{
+    documents += rhs.documents;
+    bytes += rhs.bytes;
+    for (int t = LEPT_NULL; t <= LEPT_OBJECT; t++)
+        nodes[t] += rhs.nodes[t];
+    string_bytes += rhs.string_bytes;
+    escapes += rhs.escapes;
+    max_depth = max_depth > rhs.max_depth ? max_depth : rhs.max_depth;
+    allocs += rhs.allocs;
+    string_ns += rhs.string_ns;
+    number_ns += rhs.number_ns;
+    total_ns += rhs.total_ns;
+}
+
+#ifdef LEPT_STATS
+thread_local lept_parse_stats *lept_stats = NULL;
+thread_local lept_parse_stats *lept_stats_sink = NULL; // lept_set_parse_stats 设置的统计
+
+/** 在 lept_parse_tree 执行期间打开本线程的统计 */
+struct lept_stats_scope
+{
+    explicit lept_stats_scope(lept_context &c)
+    {
+        lept_stats = lept_stats_sink;
+        if (lept_stats)
+        {
+            lept_stats->documents++;
+            lept_stats->bytes += c.end - c.json;
+            c.depth = 0;
+        }
+    }
+    ~lept_stats_scope()
+    {
+        lept_stats = NULL;
+    }
+};
+#endif
+
+bool lept_stats_enabled()
+{
+#ifdef LEPT_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+void lept_set_parse_stats(lept_parse_stats *stats)
+{
+#ifdef LEPT_STATS
+    lept_stats_sink = stats;
+#else
+    (void)stats;
+#endif
+}
+
+lept_parse_ret lept_parse_tree(lept_context &c, lept_value &v, const lept_parse_options &options)
+{
+#ifdef LEPT_STATS
+    lept_stats_scope scope(c);
+    LEPT_STATS_TIME(total_ns);
+#endif
+    c.max_depth = options.max_depth;
+    c.object_index_min = options.object_index_min;
+    c.values.clear(); // 复用的上下文中可能留有上次出错时的值
+    if (options.engine == LEPT_ENGINE_INDEXED && (uint64_t)(c.end - c.json) <= UINT32_MAX)
+        return lept_parse_indexed(c, v);
+
+    lept_value_handler h = {c};
+    lept_parse_ret ret = lept_parse_events(c, h);
+    if (ret == LEPT_PARSE_OK)
+        v = std::move(c.values.back());
+    return ret;
+}
+
+lept_parse_ret lept_value::lept_parse(lept_value &v, const char *json, const lept_parse_options &options)
+{
+    return lept_parse(v, json, strlen(json), options);
+}
+
+lept_parse_ret lept_value::lept_parse(lept_value &v, const char *json, size_t len, const lept_parse_options &options)
+{
+    lept_context c; // 定义一个上下文
+    c.json = json;
+    c.end = json + len;
+    c.arena = NULL;
+    return lept_parse_tree(c, v, options);
+}
+
+lept_value::lept_value() : size(0), type(LEPT_NULL), flags(0)
+{
+    u.n = 0;
+}
+
+/** 数组的第 i 个元素，或对象的第 i / 2 个成员的键（i 为偶数）与值（i 为奇数） */
+lept_value *lept_get_child(const lept_value &v, size_t i)
+{
+    if (v.type == LEPT_ARRAY)
+        return &v.u.a[i];
+    return i & 1 ? &v.u.o[i / 2].v : &v.u.o[i / 2].k;
+}
+
+/** 数组元素个数，或对象成员个数的两倍（键与值各算一个），与 lept_get_child 的下标对应 */
+size_t lept_get_child_count(const lept_value &v)
+{
+    return v.type == LEPT_ARRAY ? (size_t)v.size : (size_t)v.size * 2;
+}
+
+/** 拷贝或释放时尚未处理完的数组或对象 */
+struct lept_walk_frame
+{
+    const lept_value *src; // 拷贝时为源，释放时为要释放的容器
+    lept_value *dst;       // 拷贝的目标
+    size_t next;           // 下一个要处理的子节点，见 lept_get_child
+};
+
+/** 把 src 自身拷贝到 null 值 dst：数组与对象只分配存储，返回是否还有子节点要拷贝 */
+bool lept_copy_node(lept_value &dst, const lept_value &src)
+{
+    switch (src.type)
+    {
+    case LEPT_STRING:
+        lept_set_string_raw(dst, src.u.s, src.size);
+        return false;
+    case LEPT_ARRAY:
+        dst.u.a = src.size ? (lept_value *)lept_alloc(NULL, src.size * sizeof(lept_value)) : NULL;
+        break;
+    case LEPT_OBJECT:
+        dst.u.o = lept_alloc_members(NULL, src.size, src.flags & LEPT_FLAG_INDEXED);
+        break;
+    default:
+        dst.u = src.u;
+        break;
+    }
+    dst.size = src.size;
+    dst.type = src.type;
+    dst.flags = src.flags & ~LEPT_FLAG_BORROWED;
+    return (src.type == LEPT_ARRAY || src.type == LEPT_OBJECT) && src.size;
+}
+
+lept_value::lept_value(const lept_value &rhs) : size(0), type(LEPT_NULL), flags(0)
+{
+    u.n = 0;
+    if (!lept_copy_node(*this, rhs))
+        return;
+    lept_walk_stack<lept_walk_frame> stack; // 代替递归，栈的用量与嵌套深度无关
+    stack.push_back(lept_walk_frame{&rhs, this, 0});
+    while (!stack.empty())
+    {
+        const lept_value *src = stack.back().src, *s = NULL;
+        lept_value *dst = stack.back().dst, *d = NULL;
+        size_t i = stack.back().next, n = lept_get_child_count(*src);
+        for (; i < n; i++) // 逐个拷贝子节点，遇到非空的数组或对象时先拷贝其内容
+        {
+            s = lept_get_child(*src, i);
+            d = new (lept_get_child(*dst, i)) lept_value();
+            if (lept_copy_node(*d, *s))
+                break;
+        }
+        if (i < n)
+        {
+            stack.back().next = i + 1;
+            stack.push_back(lept_walk_frame{s, d, 0});
+            continue;
+        }
+        if (dst->flags & LEPT_FLAG_INDEXED) // 键都已就位
+            lept_build_index(dst->u.o, dst->size);
+        stack.pop_back();
+    }
+}
+
+lept_value::lept_value(lept_value &&rhs) noexcept : u(rhs.u), size(rhs.size), type(rhs.type), flags(rhs.flags)
+{
+    rhs.type = LEPT_NULL;
+    rhs.size = 0;
+    rhs.flags = 0;
+}
+
+lept_value &lept_value::operator=(const lept_value &rhs)
+{
+    if (this != &rhs)
+        *this = lept_value(rhs); // 先完成深拷贝，rhs 可能是 *this 的子节点
+    return *this;
+}
+
+lept_value &lept_value::operator=(lept_value &&rhs) noexcept
+{
+    if (this != &rhs)
+    {
+        lept_value t(std::move(rhs)); // rhs 可能是 *this 的子节点
+        lept_free();
+        u = t.u;
+        size = t.size;
+        type = t.type;
+        flags = t.flags;
+        t.type = LEPT_NULL;
+        t.flags = 0;
+    }
+    return *this;
+}
+
+lept_value::~lept_value()
+{
+    lept_free();
+}
+
+/** 释放数组或对象 v 的存储及其中持有的全部内容 */
+void lept_free_children(const lept_value &v)
+{
+    lept_walk_stack<lept_walk_frame> stack; // 代替递归，栈的用量与嵌套深度无关
+    stack.push_back(lept_walk_frame{&v, NULL, 0});
+    while (!stack.empty())
+    {
+        const lept_value *c = stack.back().src, *e = NULL;
+        size_t i = stack.back().next, n = lept_get_child_count(*c);
+        for (; i < n; i++) // 释放 c 的子节点持有的字符串，遇到数组或对象时先释放它
+        {
+            e = lept_get_child(*c, i);
+            if (e->flags & LEPT_FLAG_BORROWED)
+                continue;
+            if (e->type == LEPT_STRING)
+                lept_dealloc(e->u.s);
+            else if (e->type == LEPT_ARRAY || e->type == LEPT_OBJECT)
+                break;
+        }
+        if (i < n)
+        {
+            stack.back().next = i + 1;
+            stack.push_back(lept_walk_frame{e, NULL, 0});
+            continue;
+        }
+        lept_dealloc(c->type == LEPT_ARRAY ? (void *)c->u.a : (void *)c->u.o);
+        stack.pop_back();
+    }
+}
+
+void lept_value::lept_free()
+{
+    switch (this->flags & LEPT_FLAG_BORROWED ? LEPT_NULL : this->type) // 不持有的内容由其所有者统一释放
+    {
+    case LEPT_STRING:
+        lept_dealloc(this->u.s);
+        break;
+    case LEPT_ARRAY:
+    case LEPT_OBJECT:
+        lept_free_children(*this);
+        break;
+    default:
+        break;
+    }
+    this->type = LEPT_NULL;
+    this->size = 0;
+    this->flags = 0;
+    this->u.n = 0;
+}
+
+lept_type lept_value::lept_get_type() const
+{
+    return this->type;
+}
+
+bool lept_value::lept_get_boolean() const
+{
+    assert(this->type == LEPT_TRUE || this->type == LEPT_FALSE);
+    return this->type == LEPT_TRUE;
+}
+
+void lept_value::lept_set_boolean(bool b)
+{
+    lept_free();
+    this->type = b ? LEPT_TRUE : LEPT_FALSE;
+}
+
+double lept_value::lept_get_number() const
+{
+    assert(this->type == LEPT_NUMBER);
+    if (this->flags & LEPT_FLAG_INT64)
+        return (double)this->u.i64;
+    if (this->flags & LEPT_FLAG_UINT64)
+        return (double)this->u.u64;
+    return this->u.n;
+}
+
+void lept_value::lept_set_number(double n)
+{
+    lept_free();
+    this->type = LEPT_NUMBER;
+    this->u.n = n;
+}
+
+bool lept_value::lept_is_int64() const
+{
+    return this->type == LEPT_NUMBER && (this->flags & LEPT_FLAG_INT64);
+}
+
+bool lept_value::lept_is_uint64() const
+{
+    return this->type == LEPT_NUMBER &&
+           ((this->flags & LEPT_FLAG_UINT64) || ((this->flags & LEPT_FLAG_INT64) && this->u.i64 >= 0));
+}
+
+int64_t lept_value::lept_get_int64() const
+{
+    assert(lept_is_int64());
+    return this->u.i64;
+}
+
+uint64_t lept_value::lept_get_uint64() const
+{
+    assert(lept_is_uint64());
+    return this->flags & LEPT_FLAG_UINT64 ? this->u.u64 : (uint64_t)this->u.i64;
+}
+
+void lept_value::lept_set_int64(int64_t i)
+{
+    lept_free();
+    this->type = LEPT_NUMBER;
+    this->flags = LEPT_FLAG_INT64;
+    this->u.i64 = i;
+}
+
+void lept_value::lept_set_uint64(uint64_t u)
+{
+    if (u <= (uint64_t)INT64_MAX) // 统一以 int64_t 保存，只有超出范围的才用 uint64_t
+        return lept_set_int64((int64_t)u);
+    lept_free();
+    this->type = LEPT_NUMBER;
+    this->flags = LEPT_FLAG_UINT64;
+    this->u.u64 = u;
+}
+
+const char *lept_value::lept_get_string() const
+{
+    assert(this->type == LEPT_STRING);
+    return this->u.s;
+}
+
+size_t lept_value::lept_get_string_length() const
+{
+    assert(this->type == LEPT_STRING);
+    return this->size;
+}
+
+void lept_value::lept_set_string(const char *s)
+{
+    lept_set_string_raw(*this, s, strlen(s));
+}
+
+void lept_value::lept_set_string(const char *s, size_t len)
+{
+    lept_set_string_raw(*this, s, len);
+}
+
+size_t lept_value::lept_get_array_size() const
+{
+    assert(this->type == LEPT_ARRAY);
+    return this->size;
+}
+
+lept_value lept_value::lept_get_array_element(size_t index) const
+{
+    return lept_array_at(index);
+}
+
+lept_value &lept_value::lept_array_at(size_t index)
+{
+    assert(this->type == LEPT_ARRAY && index < this->size);
+    return this->u.a[index];
+}
+
+const lept_value &lept_value::lept_array_at(size_t index) const
+{
+    assert(this->type == LEPT_ARRAY && index < this->size);
+    return this->u.a[index];
+}
+
+lept_value *lept_value::lept_array_begin()
+{
+    assert(this->type == LEPT_ARRAY);
+    return this->u.a;
+}
+
+lept_value *lept_value::lept_array_end()
+{
+    assert(this->type == LEPT_ARRAY);
+    return this->u.a + this->size;
+}
+
+const lept_value *lept_value::lept_array_begin() const
+{
+    return const_cast<lept_value *>(this)->lept_array_begin();
+}
+
+const lept_value *lept_value::lept_array_end() const
+{
+    return const_cast<lept_value *>(this)->lept_array_end();
+}
+
+size_t lept_value::lept_get_object_size() const
+{
+    assert(this->type == LEPT_OBJECT);
+    return this->size;
+}
+
+lept_value lept_value::lept_get_object_value(const lept_value &k) const
+{
+    const lept_value *v = lept_find_object_value(k);
+    return v ? *v : lept_value();
+}
+
+/** 在对象 v 中查找键为 k 的成员的值，symbol 为 k 驻留时的键，用其中的散列值 */
+lept_value *lept_find_member(lept_value &v, const char *k, size_t len, const lept_value *symbol)
+{
+    assert(v.type == LEPT_OBJECT);
+
+    if (v.flags & LEPT_FLAG_INDEXED)
+    {
+        size_t cap = lept_index_capacity(v.size);
+        lept_index_slot *slots = lept_get_index(v.u.o, v.size);
+        uint32_t h = symbol ? lept_get_key_hash(*symbol) : lept_hash_key(k, len);
+        for (size_t j = h & (cap - 1); slots[j].member; j = (j + 1) & (cap - 1))
+        {
+            lept_member &m = v.u.o[slots[j].member - 1];
+            if (slots[j].hash == h && lept_key_equal(m.k, k, len))
+                return &m.v;
+        }
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < v.size; i++)
+        if (lept_key_equal(v.u.o[i].k, k, len))
+            return &v.u.o[i].v;
+
+    return NULL;
+}
+
+lept_value *lept_value::lept_find_object_value(const char *k, size_t len)
+{
+    return lept_find_member(*this, k, len, NULL);
+}
+
+const lept_value *lept_value::lept_find_object_value(const char *k, size_t len) const
+{
+    return const_cast<lept_value *>(this)->lept_find_object_value(k, len);
+}
+
+lept_value *lept_value::lept_find_object_value(const char *k)
+{
+    return lept_find_object_value(k, strlen(k));
+}
+
+const lept_value *lept_value::lept_find_object_value(const char *k) const
+{
+    return lept_find_object_value(k, strlen(k));
+}
+
+lept_value *lept_value::lept_find_object_value(const lept_value &k)
+{
+    if (k.type != LEPT_STRING) // 如 lept_document::lept_get_key 找不到的键
+        return NULL;
+    return lept_find_member(*this, k.u.s, k.size, k.flags & LEPT_FLAG_INTERNED ? &k : NULL);
+}
+
+const lept_value *lept_value::lept_find_object_value(const lept_value &k) const
+{
+    return const_cast<lept_value *>(this)->lept_find_object_value(k);
+}
+
+const lept_member &lept_value::lept_get_object_member(size_t index) const
+{
+    assert(this->type == LEPT_OBJECT && index < this->size);
+    return this->u.o[index];
+}
+
+const lept_member *lept_value::lept_object_begin() const
+{
+    assert(this->type == LEPT_OBJECT);
+    return this->u.o;
+}
+
+const lept_member *lept_value::lept_object_end() const
+{
+    assert(this->type == LEPT_OBJECT);
+    return this->u.o + this->size;
+}
+
+lept_value &lept_value::lept_object_value_at(size_t index)
+{
+    assert(this->type == LEPT_OBJECT && index < this->size);
+    return this->u.o[index].v;
+}
+
+const lept_value &lept_value::lept_object_value_at(size_t index) const
+{
+    return const_cast<lept_value *>(this)->lept_object_value_at(index);
+}
+
+void lept_value::lept_stringify(const lept_value &v, lept_buffer &b, lept_stringify_mode mode)
+{
+    lept_stringify_value(b, v, mode == LEPT_STRINGIFY_PRETTY);
+}
+
+/************************************************************************************************ */
+
+lept_arena::lept_arena(size_t block_size) : head(NULL), cur(NULL), end(NULL), block_size(block_size), used(0)
+{
+}
+
+lept_arena::~lept_arena()
+{
+    while (head)
+    {
+        lept_arena_block *next = head->next;
+        lept_dealloc(head);
+        head = next;
+    }
+}
+
+void *lept_arena::lept_alloc(size_t n)
+{
+    n = (n + 7) & ~(size_t)7; // 按 8 字节对齐
+    if ((size_t)(end - cur) < n)
+    {
+        size_t size = block_size;
+        if (head)
+            size = head->size * 2 > block_size ? head->size * 2 : block_size; // 块大小按倍数增长
+        if (size < n)
+            size = n;
+        lept_arena_block *b = (lept_arena_block *)::operator new(sizeof(lept_arena_block) + size);
+        LEPT_STATS_ADD(allocs, 1);
+        b->next = head;
+        b->size = size;
+        head = b;
+        cur = (char *)(b + 1);
+        end = cur + size;
+    }
+    void *p = cur;
+    cur += n;
+    used += n;
+    return p;
+}
+
+void lept_arena::lept_clear()
+{
+    used = 0;
+    if (!head)
+        return;
+    while (head->next) // 只保留最近（也是最大）的一块以供复用
+    {
+        lept_arena_block *next = head->next;
+        head->next = next->next;
+        lept_dealloc(next);
+    }
+    cur = (char *)(head + 1);
+    end = cur + head->size;
+}
+
+size_t lept_arena::lept_get_block_count() const
+{
+    size_t n = 0;
+    for (lept_arena_block *b = head; b; b = b->next)
+        n++;
+    return n;
+}
+
+size_t lept_arena::lept_get_used_size() const
+{
+    return used;
+}
+
+lept_parse_ret lept_document::lept_parse(const char *json)
+{
+    return lept_parse(json, strlen(json));
+}
+
+lept_document::lept_document()
+    : map(NULL), map_size(0), symbols(new lept_symbols), context(new lept_context), workers(NULL)
+{
+}
+
+lept_document::~lept_document()
+{
+    lept_unmap_file(map, map_size);
+    delete symbols;
+    delete context;
+    delete workers;
+}
+
+void lept_document::lept_reset()
+{
+    root = lept_value(); // 旧内容都在 arena 与映射中，随之一并丢弃
+    if (symbols)
+        symbols->lept_clear();
+    arena.lept_clear();
+    if (workers)
+        workers->lept_clear();
+    lept_unmap_file(map, map_size);
+    map = NULL;
+    map_size = 0;
+}
+
+lept_context &lept_document::lept_get_context(const char *json, size_t len)
+{
+    lept_context &c = *context;
+    c.json = json;
+    c.end = json + len;
+    c.arena = &arena;
+    c.symbols = symbols;
+    c.insitu = false;
+    return c;
+}
+
+lept_parse_ret lept_document::lept_parse(const char *json, size_t len)
+{
+    lept_reset();
+    return lept_parse_tree(lept_get_context(json, len), root, options);
+}
+
+lept_parse_ret lept_document::lept_parse_insitu(char *json)
+{
+    return lept_parse_insitu(json, strlen(json));
+}
+
+lept_parse_ret lept_document::lept_parse_insitu(char *json, size_t len)
+{
+    lept_reset();
+    lept_context &c = lept_get_context(json, len);
+    c.symbols = NULL; // 键直接引用输入
+    c.insitu = true;
+    return lept_parse_tree(c, root, options);
+}
+
+const lept_value &lept_document::lept_get_root() const
+{
+    return root;
+}
+
+void lept_document::lept_set_options(const lept_parse_options &options)
+{
+    this->options = options;
+}
+
+void lept_document::lept_set_intern_keys(bool intern)
+{
+    if (intern && !symbols)
+        symbols = new lept_symbols;
+    else if (!intern && symbols)
+    { // 已驻留的键仍在 arena 中，不受影响
+        delete symbols;
+        symbols = NULL;
+    }
+}
+
+lept_value lept_document::lept_get_key(const char *k, size_t len) const
+{
+    lept_value key;
+    if (char *s = symbols ? symbols->lept_find(k, len, lept_hash_key(k, len)) : NULL)
+        lept_set_symbol(key, s);
+    return key;
+}
+
+lept_value lept_document::lept_get_key(const char *k) const
+{
+    return lept_get_key(k, strlen(k));
+}
+
+size_t lept_document::lept_get_used_size() const
+{
+    return arena.lept_get_used_size() + (symbols ? symbols->slots.capacity() * sizeof(char *) : 0) +
+           (workers ? workers->lept_get_used_size() : 0);
+}
+
+lept_buffer::lept_buffer() : data(NULL), size(0), capacity(0)
+{
+}
+
+lept_buffer::~lept_buffer()
+{
+    lept_dealloc(data);
+}
+
+char *lept_buffer::lept_push(size_t n)
+{
+    if (size + n > capacity)
+    {
+        size_t cap = capacity ? capacity : 256;
+        while (cap < size + n)
+            cap += cap >> 1; // 按 1.5 倍增长
+        char *d = (char *)lept_alloc(NULL, cap + 1);
+        if (size)
+            memcpy(d, data, size);
+        lept_dealloc(data);
+        data = d;
+        capacity = cap;
+    }
+    char *p = data + size;
+    size += n;
+    data[size] = '\0';
+    return p;
+}
+
+void lept_buffer::lept_pop(size_t n)
+{
+    assert(n <= size);
+    size -= n;
+    if (data)
+        data[size] = '\0';
+}
+
+void lept_buffer::lept_clear()
+{
+    lept_pop(size);
+}
+
+const char *lept_buffer::lept_get_data() const
+{
+    return data ? data : "";
+}
+
+size_t lept_buffer::lept_get_size() const
+{
+    return size;
 }
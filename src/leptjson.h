@@ -1,6 +1,7 @@
 #pragma once
 
-#include <vector>
+#include <cstddef>
+#include <cstdint>
 
 /** 解析值的类型 */
 enum lept_type
@@ -31,34 +32,522 @@ enum lept_parse_ret
     LEPT_PARSE_MISS_KEY,                     // 没有key
     LEPT_PARSE_MISS_COLON,                   // 没有冒号
     LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET,  // 没有预期的逗号或花括号
+    LEPT_PARSE_INCOMPLETE,                   // 增量解析时输入尚不完整，需要继续送入
+    LEPT_PARSE_IO_ERROR,                     // 无法打开或读取文件
+    LEPT_PARSE_TOO_DEEP,                     // 数组与对象的嵌套超过 lept_parse_options::max_depth
+    LEPT_PARSE_TYPE_MISMATCH,                // 解析到结构体时，值的类型与字段的类型不符，见 leptjson_bind.h
 };
 
-struct lept_value
+/** 解析时使用的 SIMD 指令集 */
+enum lept_simd_level
+{
+    LEPT_SIMD_NONE, // 逐字节处理
+    LEPT_SIMD_SSE2, // 每次 16 字节
+    LEPT_SIMD_AVX2, // 每次 32 字节
+};
+
+lept_simd_level lept_get_simd_level();                      // 获取当前使用的 SIMD 级别，默认为 CPU 支持的最高级别
+lept_simd_level lept_set_simd_level(lept_simd_level level); // 设置 SIMD 级别，超出 CPU 支持时降级，返回实际生效的级别；可与解析并发调用
+
+/** 构造树时使用的解析引擎，两者的结果与错误码相同 */
+enum lept_engine
+{
+    LEPT_ENGINE_DESCENT, // 逐字符的递归下降
+    LEPT_ENGINE_INDEXED, // 先用 SIMD 为整个输入建立结构字符的索引，再沿索引构造树
+};
+
+/**
+ * 解析选项，由每次解析各自携带，同时进行的解析互不影响
+ * 解析、释放、拷贝、序列化与编码都不递归，栈的用量与嵌套深度无关，限制深度只是为了约束恶意输入占用的内存
+ */
+struct lept_parse_options
+{
+    size_t max_depth = 1024;                  // 数组与对象的最大嵌套深度，超过时解析返回 LEPT_PARSE_TOO_DEEP
+    lept_engine engine = LEPT_ENGINE_DESCENT; // 构造树时使用的引擎，增量解析、按需访问与解码不受影响
+    size_t object_index_min = 16;             // 成员数不少于此值的对象建立散列索引，查找时不必逐个比较键；为 0 时都不建立
+};
+
+/**
+ * 构造树时的解析统计
+ * 只有以 LEPT_STATS 编译（CMake 选项 JSONP_STATS）时才会记录，否则解析中不含任何统计代码，结构体始终为零。
+ * 统计按线程进行：lept_set_parse_stats 之后，本线程上的每次解析都累加到给定的结构体中
+ */
+struct lept_parse_stats
+{
+    uint64_t documents;              // 解析次数
+    uint64_t bytes;                  // 输入的字节数
+    uint64_t nodes[LEPT_OBJECT + 1]; // 各类型的节点数，按 lept_type 下标，对象的键不计入
+    uint64_t string_bytes;           // 解码后的字符串字节数，含对象的键
+    uint64_t escapes;                // 转义序列个数，代理对算一个
+    uint64_t max_depth;              // 数组与对象的最大嵌套深度
+    uint64_t allocs;                 // 内存分配次数：堆上的节点内容与 arena 新申请的块
+    uint64_t string_ns;              // 解析字符串（含键）的耗时
+    uint64_t number_ns;              // 解析数字的耗时
+    uint64_t total_ns;               // 解析的总耗时
+
+    lept_parse_stats(); // 全部清零
+
+    uint64_t lept_get_container_ns() const;     // 字符串与数字之外的耗时：空白、字面量、容器与组装
+    void lept_add(const lept_parse_stats &rhs); // 累加另一份统计，max_depth 取较大者
+};
+
+bool lept_stats_enabled(); // 编译时是否启用了统计
+
+/** 本线程之后的解析累加到 stats 中，为 NULL 时停止；多线程解析只记录在调用者所在线程完成的部分 */
+void lept_set_parse_stats(lept_parse_stats *stats);
+
+/** 从文件解析时字符串的存放方式 */
+enum lept_file_mode
+{
+    LEPT_FILE_COPY,      // 字符串复制进文档，解析结束即解除映射
+    LEPT_FILE_REFERENCE, // 字符串在文件的映射中原地解码并直接引用，映射随文档保留到下次解析或析构
+};
+
+/** 序列化的格式 */
+enum lept_stringify_mode
 {
-    std::vector<char> s;                              // 字符串
-    std::vector<lept_value> a;                        // 数组
-    double n;                                         // 数字
-    bool b;                                           // 布尔值
-    std::vector<std::pair<lept_value, lept_value>> o; //对象
+    LEPT_STRINGIFY_COMPACT, // 不含任何多余空白
+    LEPT_STRINGIFY_PRETTY,  // 每个元素、成员占一行，缩进 4 个空格
+};
+
+struct lept_buffer;
 
-    lept_type type = LEPT_NULL;
+/** lept_value::flags 的取值 */
+enum lept_flag
+{
+    LEPT_FLAG_BORROWED = 1, // 不持有字符串、数组或对象的内容，由 arena 等外部所有者统一释放
+    LEPT_FLAG_INT64 = 2,    // 数字以 int64_t 保存
+    LEPT_FLAG_UINT64 = 4,   // 数字以 uint64_t 保存
+    LEPT_FLAG_INTERNED = 8, // 对象的键驻留在文档的符号表中，同一文档中相同的键共用一份内容，见 lept_document
+    LEPT_FLAG_INDEXED = 16, // 对象在成员之后带有键的散列索引，见 lept_parse_options::object_index_min
+};
 
-    lept_value() = default;
+struct lept_member;
+
+/**
+ * 解析值
+ * 以带标签的联合体存储，只保存当前类型所需的数据，字符串、数组与对象的内容放在堆上，
+ * 每个节点固定 16 字节
+ */
+struct lept_value
+{
+    union {
+        double n;         // 数字
+        int64_t i64;      // 整数，flags 含 LEPT_FLAG_INT64 时有效
+        uint64_t u64;     // 超过 INT64_MAX 的整数，flags 含 LEPT_FLAG_UINT64 时有效
+        char *s;          // 字符串，以 '\0' 结尾
+        lept_value *a;    // 数组元素
+        lept_member *o;   // 对象成员
+    } u;
+    uint32_t size;        // 字符串长度 / 数组元素个数 / 对象成员个数
+    lept_type type : 8;   // 值的类型，true / false 直接由类型表示
+    unsigned flags : 8;   // lept_flag 的组合
 
-    static lept_parse_ret lept_parse(lept_value &v, const char *json); // 解析json文本
+    lept_value();
+    lept_value(const lept_value &rhs); // 深拷贝，结果总是持有自己的内容
+    lept_value(lept_value &&rhs) noexcept;
+    lept_value &operator=(const lept_value &rhs);
+    lept_value &operator=(lept_value &&rhs) noexcept;
+    ~lept_value();
 
-    lept_type lept_get_type(); // 获取解析值的类型
+    static lept_parse_ret lept_parse(lept_value &v, const char *json, // 解析以 '\0' 结尾的json文本
+                                     const lept_parse_options &options = lept_parse_options());
+    static lept_parse_ret lept_parse(lept_value &v, const char *json, size_t len, // 解析 [json, json + len) 中的json文本
+                                     const lept_parse_options &options = lept_parse_options());
+    template <typename S>
+    static auto lept_parse(lept_value &v, const S &json, const lept_parse_options &options = lept_parse_options())
+        -> decltype(json.data(), json.size(), LEPT_PARSE_OK)
+    { // 解析 std::string、std::string_view 等提供 data() 与 size() 的连续文本
+        return lept_parse(v, json.data(), json.size(), options);
+    }
+    static lept_parse_ret lept_parse_file(lept_value &v, const char *path, // 映射文件并直接从映射中解析
+                                          const lept_parse_options &options = lept_parse_options());
+    /**
+     * 用 threads 个线程解析根为数组的 [json, json + len)，threads 为 0 时使用硬件线程数：
+     * 先并行扫描出顶层元素的边界，再并行解析各元素，按原顺序组装。结果与错误码都与 lept_parse 相同，
+     * 有多处错误时报告位置最靠前的一处；根不是数组时直接顺序解析。
+     * 各线程在堆上构造元素，分配会在 malloc 中争用；结果只需读取时用 lept_document::lept_parse_parallel
+     */
+    static lept_parse_ret lept_parse_parallel(lept_value &v, const char *json, size_t len, unsigned threads = 0,
+                                              const lept_parse_options &options = lept_parse_options());
+    static void lept_stringify(const lept_value &v, lept_buffer &b,
+                               lept_stringify_mode mode = LEPT_STRINGIFY_COMPACT); // 序列化为json文本，追加到 b 末尾
+    static void lept_encode(const lept_value &v, lept_buffer &b); // 编码为二进制 tape，追加到 b 末尾，见 lept_tape_value
+    static lept_parse_ret lept_decode(lept_value &v, const char *data, size_t len, // 从二进制 tape 还原出树
+                                      const lept_parse_options &options = lept_parse_options());
 
-    bool lept_get_boolean(); // 获取布尔值
+    lept_type lept_get_type() const; // 获取解析值的类型
+
+    bool lept_get_boolean() const; // 获取布尔值
     void lept_set_boolean(bool b);
 
-    double lept_get_number(); // 获取数值类型的值
+    double lept_get_number() const; // 获取数值类型的值，整数会转换为 double
     void lept_set_number(double n);
 
-    const char *lept_get_string(); // 获取字符串
+    bool lept_is_int64() const;     // 是否为能以 int64_t 表示的整数
+    bool lept_is_uint64() const;    // 是否为能以 uint64_t 表示的整数
+    int64_t lept_get_int64() const; // 获取整数值
+    uint64_t lept_get_uint64() const;
+    void lept_set_int64(int64_t i);
+    void lept_set_uint64(uint64_t u);
+
+    const char *lept_get_string() const;  // 获取字符串
+    size_t lept_get_string_length() const; // 获取字符串长度
     void lept_set_string(const char *s);
+    void lept_set_string(const char *s, size_t len); // 设置长度为 len 的字符串，可以包含 '\0'
+
+    size_t lept_get_array_size() const;                     // 获取数组元素个数
+    lept_value lept_get_array_element(size_t index) const; // 获取数组元素的拷贝
+    lept_value &lept_array_at(size_t index);               // 获取数组元素的引用
+    const lept_value &lept_array_at(size_t index) const;
+    lept_value *lept_array_begin(); // 遍历数组元素
+    lept_value *lept_array_end();
+    const lept_value *lept_array_begin() const;
+    const lept_value *lept_array_end() const;
+
+    size_t lept_get_object_size() const;                         // 获取对象成员个数
+    lept_value lept_get_object_value(const lept_value &k) const; // 获取对象值的拷贝，不存在时为 null
+    lept_value *lept_find_object_value(const char *k, size_t len); // 查找对象值，不存在时返回 NULL
+    const lept_value *lept_find_object_value(const char *k, size_t len) const;
+    lept_value *lept_find_object_value(const char *k);
+    const lept_value *lept_find_object_value(const char *k) const;
+    lept_value *lept_find_object_value(const lept_value &k); // k 不是字符串时返回 NULL
+    const lept_value *lept_find_object_value(const lept_value &k) const;
+    /** 按 JSON Pointer（RFC 6901）查找，如 "/items/0/price"，空串为自身；不存在或语法错误时返回 NULL */
+    lept_value *lept_find_pointer(const char *pointer, size_t len);
+    const lept_value *lept_find_pointer(const char *pointer, size_t len) const;
+    lept_value *lept_find_pointer(const char *pointer);
+    const lept_value *lept_find_pointer(const char *pointer) const;
+    /** 按插入顺序获取、遍历对象成员；键可能已建立散列索引，只能读取，修改值用 lept_object_value_at */
+    const lept_member &lept_get_object_member(size_t index) const;
+    const lept_member *lept_object_begin() const;
+    const lept_member *lept_object_end() const;
+    lept_value &lept_object_value_at(size_t index); // 按插入顺序获取对象值的引用
+    const lept_value &lept_object_value_at(size_t index) const;
+
+    void lept_free(); // 释放所持有的内容，并置为 null
+};
+
+/** 对象成员 */
+struct lept_member
+{
+    lept_value k; // 键，对象只以 const 方式交出成员，键不会在散列索引之外被改动
+    lept_value v; // 值
+};
+
+struct lept_arena_block;
+
+/**
+ * 线性分配器
+ * 从少量大块内存中顺序分配，不支持单独释放，所有内容在 lept_clear 或析构时一次性归还
+ */
+struct lept_arena
+{
+    explicit lept_arena(size_t block_size = 64 * 1024);
+    lept_arena(const lept_arena &) = delete;
+    lept_arena &operator=(const lept_arena &) = delete;
+    ~lept_arena();
+
+    void *lept_alloc(size_t n); // 分配 n 个字节，按 8 字节对齐
+    void lept_clear();          // 归还所有已分配的内容，保留一块内存供复用
+
+    size_t lept_get_block_count() const; // 当前持有的内存块数
+    size_t lept_get_used_size() const;   // 自上次 lept_clear 以来分配出去的字节数，含对齐的填充
+
+  private:
+    lept_arena_block *head; // 最近分配的块，各块串成链表
+    char *cur;              // 当前块中下一次分配的位置
+    char *end;              // 当前块的末尾
+    size_t block_size;      // 首块大小
+    size_t used;            // 已分配出去的字节数
+};
+
+/** 内存块头，块中内容紧随其后 */
+struct lept_arena_block
+{
+    lept_arena_block *next;
+    size_t size;
+};
+
+struct lept_symbols;
+struct lept_context;
+struct lept_workers;
+
+/**
+ * 由 arena 承载的文档
+ * 解析出的所有节点、字符串与成员都分配在文档自己的 arena 中，释放文档的代价与节点数无关；
+ * 树只能以只读方式访问，需要修改时先拷贝出一份 lept_value。
+ * 对象的键默认驻留在文档的符号表中：相同的键只存放一份，带有 LEPT_FLAG_INTERNED，
+ * 以 lept_get_key 得到的键查找对象时不必再计算散列，命中时只比较指针。原地解析时键直接引用输入，不驻留
+ */
+struct lept_document
+{
+    lept_document();
+    lept_document(const lept_document &) = delete;
+    lept_document &operator=(const lept_document &) = delete;
+    ~lept_document();
+
+    lept_parse_ret lept_parse(const char *json);             // 解析以 '\0' 结尾的json文本，之前的内容会被丢弃
+    lept_parse_ret lept_parse(const char *json, size_t len); // 解析 [json, json + len) 中的json文本
+    template <typename S> auto lept_parse(const S &json) -> decltype(json.data(), json.size(), LEPT_PARSE_OK)
+    {
+        return lept_parse(json.data(), json.size());
+    }
+    lept_parse_ret lept_parse_file(const char *path, lept_file_mode mode = LEPT_FILE_COPY); // 映射文件并解析
+
+    /**
+     * 原地解析可写的文本：转义在 json 中就地解码，字符串节点直接引用其中的内容，解析字符串不分配内存
+     * json 的内容会被改写，且须比文档的树存活得久
+     */
+    lept_parse_ret lept_parse_insitu(char *json);
+    lept_parse_ret lept_parse_insitu(char *json, size_t len);
+
+    lept_parse_ret lept_decode(const char *data, size_t len); // 从二进制 tape 还原出树，内容复制进文档
+
+    /**
+     * 用 threads 个线程解析根为数组的 [json, json + len)，切分与结果见 lept_value::lept_parse_parallel；
+     * 各线程从文档中各自的 arena 分配，互不争用，并行解析时对象的键不驻留
+     */
+    lept_parse_ret lept_parse_parallel(const char *json, size_t len, unsigned threads = 0);
+    template <typename S>
+    auto lept_parse_parallel(const S &json, unsigned threads = 0) -> decltype(json.data(), json.size(), LEPT_PARSE_OK)
+    {
+        return lept_parse_parallel(json.data(), json.size(), threads);
+    }
+
+    const lept_value &lept_get_root() const; // 获取根节点
+
+    void lept_set_options(const lept_parse_options &options); // 之后各次解析（含还原 tape）使用的选项
+    void lept_set_intern_keys(bool intern); // 之后的解析是否驻留对象的键，默认驻留；键几乎都不重复时可以关闭
+    /** 文档中驻留的键 k，用于 lept_value::lept_find_object_value；文档中没有这个键或未驻留时为 null，查找的结果为 NULL */
+    lept_value lept_get_key(const char *k, size_t len) const;
+    lept_value lept_get_key(const char *k) const;
+    size_t lept_get_used_size() const; // 树占用的字节数：arena 中分配出去的内容加上符号表
+
+  private:
+    lept_arena arena;
+    lept_value root;
+    char *map;       // LEPT_FILE_REFERENCE 模式下被字符串引用的文件映射
+    size_t map_size;
+    lept_symbols *symbols; // 驻留的键，为 NULL 时不驻留
+    lept_parse_options options;
+    lept_context *context; // 各次解析复用的上下文，值栈、转义缓冲与结构索引不必每次重新分配
+    lept_workers *workers; // lept_parse_parallel 各线程的 arena 与上下文，首次并行解析时创建
+
+    void lept_reset(); // 丢弃上一次解析的内容
+    lept_context &lept_get_context(const char *json, size_t len); // 为解析 [json, json + len) 准备好复用的上下文
+};
+
+/**
+ * 按需访问的json值
+ * 不预先解析，只记录值在文本中的位置：查找成员或元素时，途经的其他值只做括号匹配而不解码，
+ * 调用 lept_get_value 时才解码所需的值，未访问的部分也不做校验。
+ * 访问失败得到的值不再指向文本，之后的访问都返回同样的结果，可以连续调用后只检查一次。
+ * 文本须在访问期间保持有效
+ */
+struct lept_lazy_value
+{
+    lept_lazy_value();
+
+    static lept_lazy_value lept_parse(const char *json, size_t len); // 定位 [json, json + len) 中的根值
+    static lept_lazy_value lept_parse(const char *json);
+
+    bool lept_is_valid() const;          // 是否指向一个值；成员或元素不存在、类型不符或出错时为 false
+    lept_parse_ret lept_get_error() const; // 访问中遇到的错误，不存在或类型不符时仍为 LEPT_PARSE_OK
+    lept_type lept_get_type() const;     // 由首字符确定，无效时为 LEPT_NULL
+
+    lept_lazy_value lept_find_object_value(const char *k, size_t len) const; // 查找对象的成员，重复的键取第一个
+    lept_lazy_value lept_find_object_value(const char *k) const;
+    lept_lazy_value lept_array_at(size_t index) const; // 获取数组的第 index 个元素
+
+    /** 完整解码这个值，无效时返回访问中的错误或 LEPT_PARSE_INVALID_VALUE */
+    lept_parse_ret lept_get_value(lept_value &v, const lept_parse_options &options = lept_parse_options()) const;
+
+  private:
+    const char *json; // 值的起始位置，无效时为 NULL
+    const char *end;  // 整个文本的末尾
+    lept_parse_ret ret;
+
+    friend struct lept_path; // 在文本上求值时构造结果
+};
+
+struct lept_path_state;
+
+/**
+ * 预先编译的路径
+ * 写法与 JSON Pointer（RFC 6901）相同，另外只含 "*" 的一段匹配数组的每个元素或对象的每个成员。
+ * 编译一次之后可以在任意多个文档上求值，求值不分配内存，结果按文档中的顺序给出。
+ * 也可以直接在 json 文本上求值：与 lept_lazy_value 一样，途经的其他值只做括号匹配而不解码，
+ * 找到路径上的键之后不再扫描对象的其余部分
+ */
+struct lept_path
+{
+    lept_path();
+    lept_path(const lept_path &) = delete;
+    lept_path &operator=(const lept_path &) = delete;
+    ~lept_path();
+
+    bool lept_compile(const char *pointer, size_t len); // 语法错误时返回 false，之后的求值都没有结果
+    bool lept_compile(const char *pointer);
+
+    const lept_value *lept_find(const lept_value &v) const; // 第一个匹配的值，没有时返回 NULL
+    size_t lept_find_all(const lept_value &v, const lept_value **out, size_t capacity) const; // 写入前 capacity 个匹配，返回匹配的总数
+
+    lept_lazy_value lept_find(const char *json, size_t len) const; // 在文本上求值，出错时结果无效并带有错误
+    /** 在文本上求值，写入前 capacity 个匹配，count 为匹配的总数；返回扫描中遇到的错误 */
+    lept_parse_ret lept_find_all(const char *json, size_t len, lept_lazy_value *out, size_t capacity,
+                                 size_t &count) const;
+
+  private:
+    lept_path_state *state;
+};
+
+/**
+ * 二进制 tape 中的值
+ * lept_value::lept_encode 把树写成一段连续、不含指针的字节：每个值以 1 字节的标签开头，数字直接跟 8 字节的值，
+ * 字符串跟 4 字节长度、内容与 '\0'，数组与对象跟 4 字节的元素或成员个数与 8 字节的内容长度，
+ * 成员的键与字符串的格式相同（没有标签）。整数按本机字节序存放，字节序不同的机器上打开时文件头不匹配。
+ * tape 可以写入文件，之后映射到内存中直接访问，不需要解析：跳过一个值只需读出它的长度，
+ * 字符串直接指向 tape 中的内容。访问时检查各值都在 tape 的范围内，损坏的 tape 只会得到无效的值。
+ * tape 须在访问期间保持有效
+ */
+struct lept_tape_value
+{
+    lept_tape_value();
+
+    static lept_tape_value lept_open(const char *data, size_t len); // 检查文件头，定位根值
+
+    bool lept_is_valid() const;      // 是否指向一个值；成员或元素不存在、类型不符或 tape 损坏时为 false
+    lept_type lept_get_type() const; // 无效时为 LEPT_NULL
+
+    bool lept_get_boolean() const;
+    double lept_get_number() const; // 整数会转换为 double
+    bool lept_is_int64() const;
+    bool lept_is_uint64() const;
+    int64_t lept_get_int64() const;
+    uint64_t lept_get_uint64() const;
+    const char *lept_get_string() const; // 指向 tape 中以 '\0' 结尾的内容
+    size_t lept_get_string_length() const;
+
+    size_t lept_get_array_size() const;
+    lept_tape_value lept_array_at(size_t index) const; // 逐个跳过前面的元素，每个元素 O(1)
+    size_t lept_get_object_size() const;
+    lept_tape_value lept_find_object_value(const char *k, size_t len) const; // 重复的键取第一个
+    lept_tape_value lept_find_object_value(const char *k) const;
+
+    /** 顺序遍历：数组的第一个元素或对象第一个成员的值，之后依次取下一个，到末尾时无效 */
+    lept_tape_value lept_get_first() const;
+    lept_tape_value lept_get_next() const;
+    const char *lept_get_key() const; // 作为对象成员的值时，成员的键；否则为 NULL
+    size_t lept_get_key_length() const;
+
+    /** 把这个值还原为树，无效时返回 LEPT_PARSE_INVALID_VALUE */
+    lept_parse_ret lept_get_value(lept_value &v, const lept_parse_options &options = lept_parse_options()) const;
+
+  private:
+    const char *p;   // 标签，无效时为 NULL
+    const char *end; // 所在容器内容的末尾，根值为 tape 的末尾
+    const char *key; // 成员的键（长度处），不是成员时为 NULL
+
+    static lept_tape_value lept_at(const char *p, const char *end, bool member); // [p, end) 开头的值或成员，不完整时无效
+};
+
+/** 映射到内存中的 tape 文件，取得的值在下次打开或析构前有效 */
+struct lept_tape_file
+{
+    lept_tape_file();
+    lept_tape_file(const lept_tape_file &) = delete;
+    lept_tape_file &operator=(const lept_tape_file &) = delete;
+    ~lept_tape_file();
+
+    lept_parse_ret lept_open(const char *path); // 无法读取时返回 LEPT_PARSE_IO_ERROR，不是有效的 tape 时返回 LEPT_PARSE_INVALID_VALUE
+    lept_tape_value lept_get_root() const;
+
+  private:
+    char *map;
+    size_t map_size;
+    lept_tape_value root;
+};
+
+struct lept_stream_state;
+
+/**
+ * 增量解析器
+ * 输入可以分成任意多块依次送入，跨越分块边界的字符串、数字、转义与字面量会暂存下来在后续块中接续；
+ * 已读到的部分随即组装进树，不需要先把整个输入收集到一起
+ */
+struct lept_stream
+{
+    explicit lept_stream(const lept_parse_options &options = lept_parse_options()); // 各个文档都使用 options
+    lept_stream(const lept_stream &) = delete;
+    lept_stream &operator=(const lept_stream &) = delete;
+    ~lept_stream();
+
+    /**
+     * 送入一块输入，块可以为任意长度
+     * 返回 LEPT_PARSE_INCOMPLETE 表示需要更多输入，LEPT_PARSE_OK 表示根值已经完整（之后只能再有空白），
+     * 其余为解析错误，出错后的输入都被忽略
+     */
+    lept_parse_ret lept_feed(const char *data, size_t len);
+
+    /** 输入结束，结果移动到 v 中，返回值与一次性解析整个输入相同；之后可以开始解析下一个文档 */
+    lept_parse_ret lept_finish(lept_value &v);
+
+  private:
+    lept_stream_state *state;
+};
+
+struct lept_batch_state;
+
+/**
+ * NDJSON（JSON Lines）的批量解析器
+ * 输入按 '\n' 切分为记录，每行一个 json 值（json 中的换行只能作为字符串之外的空白出现，切分时不需要识别字符串），
+ * 只含空白的行被忽略。各记录由多个线程并行解析，每个线程从自己的 arena 分配，互不争用；
+ * 与 lept_document 一样，结果只读，在下次解析或析构时一并释放
+ */
+struct lept_batch
+{
+    explicit lept_batch(unsigned threads = 0); // threads 为 0 时使用硬件线程数
+    lept_batch(const lept_batch &) = delete;
+    lept_batch &operator=(const lept_batch &) = delete;
+    ~lept_batch();
+
+    void lept_set_threads(unsigned threads); // 设置之后解析使用的线程数，为 0 时使用硬件线程数
+    unsigned lept_get_threads() const;
+    void lept_set_options(const lept_parse_options &options); // 之后各次解析使用的选项
+
+    size_t lept_parse_lines(const char *json, size_t len); // 解析 [json, json + len) 中的各行，返回记录数
+    template <typename S> auto lept_parse_lines(const S &json) -> decltype(json.data(), json.size(), size_t())
+    {
+        return lept_parse_lines(json.data(), json.size());
+    }
+
+    size_t lept_get_size() const;                         // 记录数
+    const lept_value &lept_get_value(size_t index) const; // 第 index 条记录的值，解析失败时为 null
+    lept_parse_ret lept_get_error(size_t index) const;    // 第 index 条记录的解析结果
+    size_t lept_get_offset(size_t index) const;           // 第 index 条记录所在行在输入中的起始位置
+
+  private:
+    lept_batch_state *state;
+};
+
+/** 可复用的输出缓冲，清空时保留已分配的空间，反复使用时不再分配内存 */
+struct lept_buffer
+{
+    lept_buffer();
+    lept_buffer(const lept_buffer &) = delete;
+    lept_buffer &operator=(const lept_buffer &) = delete;
+    ~lept_buffer();
+
+    char *lept_push(size_t n); // 在末尾追加 n 个字节，返回其起始位置供写入
+    void lept_pop(size_t n);   // 去掉末尾的 n 个字节
+    void lept_clear();         // 清空内容
 
-    lept_value lept_get_array_element(std::vector<lept_value>::size_type index); // 获取数组元素
+    const char *lept_get_data() const; // 获取内容，以 '\0' 结尾
+    size_t lept_get_size() const;      // 获取内容的长度
 
-    lept_value lept_get_object_value(const lept_value &k); // 获取对象值
+  private:
+    char *data;
+    size_t size;
+    size_t capacity; // 不含结尾的 '\0'
 };
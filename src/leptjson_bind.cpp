@@ -0,0 +1,144 @@
+#include "leptjson_bind.h"
+#include "leptjson_internal.h"
+
+void lept_make_field_table(lept_field_table &t, const lept_field_name *names, size_t n)
+{
+    size_t size = 1;
+    while (size < n * 2) // 装载因子不超过一半时，很快就能找到没有冲突的种子
+        size *= 2;
+    for (;; size *= 2)
+        for (uint32_t seed = 0; seed < 256; seed++)
+        {
+            t.slots.assign(size, -1);
+            bool ok = true;
+            for (size_t i = 0; i < n && ok; i++)
+            {
+                int32_t &slot = t.slots[lept_field_hash(names[i].name, names[i].len, seed) & (size - 1)];
+                if (slot < 0)
+                    slot = (int32_t)i;
+                else // 重复的名字总是落在同一个槽中，保留先出现的
+                    ok = names[slot].len == names[i].len && memcmp(names[slot].name, names[i].name, names[i].len) == 0;
+            }
+            if (ok)
+            {
+                t.seed = seed;
+                t.mask = (uint32_t)(size - 1);
+                return;
+            }
+        }
+}
+
+/** 只校验语法、不做任何事的处理器 */
+struct lept_bind_skip_handler
+{
+    void lept_null()
+    {
+    }
+    void lept_boolean(bool)
+    {
+    }
+    void lept_number(double)
+    {
+    }
+    void lept_int64(int64_t)
+    {
+    }
+    void lept_uint64(uint64_t)
+    {
+    }
+    void lept_string(const char *, size_t)
+    {
+    }
+    void lept_start_array()
+    {
+    }
+    void lept_end_array(size_t)
+    {
+    }
+    void lept_start_object()
+    {
+    }
+    void lept_key(const char *, size_t)
+    {
+    }
+    void lept_end_object(size_t)
+    {
+    }
+};
+
+lept_parse_ret lept_bind_skip(lept_reader &r)
+{
+    lept_bind_skip_handler h;
+    return lept_parse_value(r, h); // r.max_depth 为剩余可用的深度
+}
+
+lept_parse_ret lept_bind_check(const char *json, size_t len, const lept_parse_options &options)
+{
+    lept_reader r;
+    r.json = json;
+    r.end = json + len;
+    r.max_depth = options.max_depth;
+    lept_parse_whitespace(r);
+    lept_parse_ret ret = lept_bind_skip(r);
+    if (ret == LEPT_PARSE_OK)
+    {
+        lept_parse_whitespace(r);
+        if (r.json != r.end)
+            ret = LEPT_PARSE_ROOT_NOT_SINGULAR;
+    }
+    return ret;
+}
+
+lept_parse_ret lept_bind_other(lept_reader &r)
+{
+    bool null = lept_peek(r, r.json) == 'n';
+    lept_parse_ret ret = lept_bind_skip(r);
+    if (ret != LEPT_PARSE_OK)
+        return ret;
+    return null ? LEPT_PARSE_OK : LEPT_PARSE_TYPE_MISMATCH;
+}
+
+lept_parse_ret lept_parse_field(lept_reader &r, bool &b)
+{
+    char ch = lept_peek(r, r.json);
+    if (ch != 't' && ch != 'f')
+        return lept_bind_other(r);
+    lept_value v;
+    lept_parse_ret ret = lept_parse_literal(r, v);
+    if (ret == LEPT_PARSE_OK)
+        b = v.type == LEPT_TRUE;
+    return ret;
+}
+
+lept_parse_ret lept_parse_field(lept_reader &r, double &d)
+{
+    char ch = lept_peek(r, r.json);
+    if (ch != '-' && (ch < '0' || ch > '9'))
+        return lept_bind_other(r);
+    lept_value v;
+    lept_parse_ret ret = lept_parse_number(r, v);
+    if (ret == LEPT_PARSE_OK)
+        d = v.lept_get_number();
+    return ret;
+}
+
+lept_parse_ret lept_parse_field(lept_reader &r, float &f)
+{
+    double d = f; // null 时保持原样
+    lept_parse_ret ret = lept_parse_field(r, d);
+    if (ret == LEPT_PARSE_OK)
+        f = (float)d;
+    return ret;
+}
+
+lept_parse_ret lept_parse_field(lept_reader &r, std::string &s)
+{
+    if (lept_peek(r, r.json) != '"')
+        return lept_bind_other(r);
+    const char *k;
+    size_t len;
+    lept_parse_ret ret = lept_parse_string_raw(r, k, len);
+    if (ret == LEPT_PARSE_OK)
+        s.assign(k, len);
+    return ret;
+}
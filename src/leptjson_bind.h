@@ -0,0 +1,282 @@
+#pragma once
+
+#include "leptjson.h"
+#include "leptjson_sax.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/*
+ * 直接解析到结构体
+ * 为结构体列出要绑定的字段，之后 lept_parse_into 一遍就把 json 文本解析进结构体，不构造 lept_value 树：
+ *
+ *     struct point { int x; double y; std::string label; std::vector<int> tags; };
+ *     LEPT_BIND_BEGIN(point)
+ *         LEPT_BIND_FIELD(x)
+ *         LEPT_BIND_FIELD(y)
+ *         LEPT_BIND_FIELD_AS(label, "name") // 键与成员名不同
+ *         LEPT_BIND_FIELD(tags)
+ *     LEPT_BIND_END()
+ *
+ *     point p;
+ *     lept_parse_ret ret = lept_parse_into(p, json, len);
+ *
+ * 宏须在全局命名空间中使用。字段可以是 bool、整数、浮点数、std::string、已绑定的结构体，以及它们的 std::vector。
+ * 键由编译期的字段表建立完美散列查找，每个键只计算一次散列、比较一次；不认识的键连同其值被跳过。
+ * 文本中没有的字段与值为 null 的字段保持原样，数组字段被整体替换。
+ * 语法错误与 lept_parse 返回的相同；值的类型与字段不符时返回 LEPT_PARSE_TYPE_MISMATCH，
+ * 整数超出字段类型的范围时返回 LEPT_PARSE_NUMBER_TOO_BIG。出错时结构体中已经写入的字段不会撤回
+ */
+
+template <typename T> struct lept_binding; // 由 LEPT_BIND_BEGIN 为各结构体特化
+
+/** 结构体的一个字段：键与解析到该成员的函数 */
+template <typename T> struct lept_field
+{
+    const char *name;
+    size_t len;
+    lept_parse_ret (*parse)(lept_reader &r, T &obj);
+};
+
+#define LEPT_BIND_BEGIN(T)                                                                                             \
+    template <> struct lept_binding<T>                                                                                 \
+    {                                                                                                                  \
+        typedef T lept_bound;                                                                                          \
+        static const lept_field<T> *lept_get_fields(size_t &n)                                                         \
+        {                                                                                                              \
+            static const lept_field<T> fields[] = {
+#define LEPT_BIND_FIELD_AS(member, key)                                                                                \
+    {key, sizeof(key) - 1, &lept_parse_member<lept_bound, decltype(lept_bound::member), &lept_bound::member>},
+#define LEPT_BIND_FIELD(member) LEPT_BIND_FIELD_AS(member, #member)
+#define LEPT_BIND_END()                                                                                                \
+            };                                                                                                         \
+            n = sizeof(fields) / sizeof(fields[0]);                                                                    \
+            return fields;                                                                                             \
+        }                                                                                                              \
+    };
+
+/** 字段名 */
+struct lept_field_name
+{
+    const char *name;
+    size_t len;
+};
+
+/** 字段名的完美散列表：各字段名落在不同的槽中 */
+struct lept_field_table
+{
+    uint32_t seed;
+    uint32_t mask;
+    std::vector<int32_t> slots; // 字段下标，空槽为 -1
+};
+
+inline uint32_t lept_field_hash(const char *k, size_t len, uint32_t seed)
+{
+    uint32_t h = 2166136261u ^ (seed * 0x9e3779b9u); // 带种子的 FNV-1a
+    for (size_t i = 0; i < len; i++)
+        h = (h ^ (unsigned char)k[i]) * 16777619u;
+    return h ^ (h >> 15);
+}
+
+/** 为 n 个字段名找到没有冲突的种子与表长；名字重复时只有第一个生效 */
+void lept_make_field_table(lept_field_table &t, const lept_field_name *names, size_t n);
+
+/** 结构体的字段及其散列表，第一次使用时建立 */
+template <typename T> struct lept_field_set
+{
+    const lept_field<T> *fields;
+    size_t n;
+    lept_field_table table;
+
+    lept_field_set()
+    {
+        fields = lept_binding<T>::lept_get_fields(n);
+        std::vector<lept_field_name> names(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            names[i].name = fields[i].name;
+            names[i].len = fields[i].len;
+        }
+        lept_make_field_table(table, names.data(), n);
+    }
+};
+
+/** 键为 k 的字段，没有时返回 NULL */
+template <typename T> const lept_field<T> *lept_find_field(const char *k, size_t len)
+{
+    static const lept_field_set<T> set; // 之后只读，多线程同时使用无妨
+    int32_t i = set.table.slots[lept_field_hash(k, len, set.table.seed) & set.table.mask];
+    if (i < 0)
+        return NULL;
+    const lept_field<T> &f = set.fields[i];
+    return f.len == len && memcmp(f.name, k, len) == 0 ? &f : NULL;
+}
+
+/** 值不能解析到字段：值为 null 时吃掉并保持字段原样；否则先完整校验这个值，语法错误优先于类型不符 */
+lept_parse_ret lept_bind_other(lept_reader &r);
+
+/** 跳过不认识的键的值，同样完整校验 */
+lept_parse_ret lept_bind_skip(lept_reader &r);
+
+/** 只校验 [json, json + len) 的语法，返回以同样的 options 调用 lept_parse 会返回的错误 */
+lept_parse_ret lept_bind_check(const char *json, size_t len, const lept_parse_options &options);
+
+/* 各类字段的解析，r.json 处应当是一个值 */
+lept_parse_ret lept_parse_field(lept_reader &r, bool &b);
+lept_parse_ret lept_parse_field(lept_reader &r, double &d);
+lept_parse_ret lept_parse_field(lept_reader &r, float &f);
+lept_parse_ret lept_parse_field(lept_reader &r, std::string &s);
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value, lept_parse_ret>::type lept_parse_field(lept_reader &r, T &i);
+template <typename T> lept_parse_ret lept_parse_field(lept_reader &r, std::vector<T> &a);
+template <typename T>
+typename std::enable_if<std::is_class<T>::value, lept_parse_ret>::type lept_parse_field(lept_reader &r, T &obj);
+
+template <typename T, typename M, M T::*P> lept_parse_ret lept_parse_member(lept_reader &r, T &obj)
+{
+    return lept_parse_field(r, obj.*P);
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value, lept_parse_ret>::type lept_parse_field(lept_reader &r, T &i)
+{
+    char ch = lept_peek(r, r.json);
+    if (ch != '-' && (ch < '0' || ch > '9'))
+        return lept_bind_other(r);
+    lept_value v;
+    lept_parse_ret ret = lept_parse_number(r, v);
+    if (ret != LEPT_PARSE_OK)
+        return ret;
+
+    typedef std::numeric_limits<T> limits;
+    bool in_range;
+    if (v.flags & LEPT_FLAG_INT64)
+        in_range = limits::is_signed ? v.u.i64 >= (int64_t)limits::min() && v.u.i64 <= (int64_t)limits::max()
+                                     : v.u.i64 >= 0 && (uint64_t)v.u.i64 <= (uint64_t)limits::max();
+    else if (v.flags & LEPT_FLAG_UINT64)
+        in_range = !limits::is_signed && v.u.u64 <= (uint64_t)limits::max();
+    else
+    { // 带小数或指数的数字，或超出 uint64_t 的整数；值恰为整数时也接受
+        double d = v.u.n, bound = std::ldexp(1.0, limits::digits);
+        if (d != std::floor(d))
+            return LEPT_PARSE_TYPE_MISMATCH;
+        in_range = d < bound && d >= (limits::is_signed ? -bound : 0);
+        if (in_range)
+        {
+            i = (T)d;
+            return LEPT_PARSE_OK;
+        }
+    }
+    if (!in_range)
+        return LEPT_PARSE_NUMBER_TOO_BIG;
+    i = v.flags & LEPT_FLAG_INT64 ? (T)v.u.i64 : (T)v.u.u64;
+    return LEPT_PARSE_OK;
+}
+
+template <typename T> lept_parse_ret lept_parse_field(lept_reader &r, std::vector<T> &a)
+{
+    if (lept_peek(r, r.json) != '[')
+        return lept_bind_other(r);
+    if (r.max_depth == 0) // 剩余可用的嵌套深度
+        return LEPT_PARSE_TOO_DEEP;
+    r.max_depth--;
+    r.json++;
+    lept_parse_whitespace(r);
+    a.clear();
+    if (lept_peek(r, r.json) != ']')
+        while (true)
+        {
+            T e = T(); // std::vector<bool> 的元素不能以 bool & 引用，先解析到局部变量
+            lept_parse_ret ret = lept_parse_field(r, e);
+            if (ret != LEPT_PARSE_OK)
+                return ret;
+            a.push_back(std::move(e));
+            lept_parse_whitespace(r);
+            if (lept_peek(r, r.json) == ']')
+                break;
+            if (lept_peek(r, r.json) != ',')
+                return LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+            r.json++;
+            lept_parse_whitespace(r);
+        }
+    r.json++;
+    r.max_depth++;
+    return LEPT_PARSE_OK;
+}
+
+template <typename T>
+typename std::enable_if<std::is_class<T>::value, lept_parse_ret>::type lept_parse_field(lept_reader &r, T &obj)
+{
+    if (lept_peek(r, r.json) != '{')
+        return lept_bind_other(r);
+    if (r.max_depth == 0)
+        return LEPT_PARSE_TOO_DEEP;
+    r.max_depth--;
+    r.json++;
+    lept_parse_whitespace(r);
+    if (lept_peek(r, r.json) != '}')
+        while (true)
+        {
+            if (lept_peek(r, r.json) != '"')
+                return LEPT_PARSE_MISS_KEY;
+            const char *k;
+            size_t len;
+            lept_parse_ret ret = lept_parse_string_raw(r, k, len);
+            if (ret != LEPT_PARSE_OK)
+                return ret;
+            const lept_field<T> *f = lept_find_field<T>(k, len); // k 可能在 r.chars 中，先于解析值查找
+            lept_parse_whitespace(r);
+            if (lept_peek(r, r.json) != ':')
+                return LEPT_PARSE_MISS_COLON;
+            r.json++;
+            lept_parse_whitespace(r);
+            if ((ret = f ? f->parse(r, obj) : lept_bind_skip(r)) != LEPT_PARSE_OK)
+                return ret;
+            lept_parse_whitespace(r);
+            if (lept_peek(r, r.json) == '}')
+                break;
+            if (lept_peek(r, r.json) != ',')
+                return LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+            r.json++;
+            lept_parse_whitespace(r);
+        }
+    r.json++;
+    r.max_depth++;
+    return LEPT_PARSE_OK;
+}
+
+/** 把 [json, json + len) 中的json文本解析进 obj，obj 可以是已绑定的结构体或其他可作为字段的类型 */
+template <typename T>
+lept_parse_ret lept_parse_into(T &obj, const char *json, size_t len,
+                               const lept_parse_options &options = lept_parse_options())
+{
+    lept_reader r;
+    r.json = json;
+    r.end = json + len;
+    r.max_depth = options.max_depth;
+    lept_parse_whitespace(r);
+    lept_parse_ret ret = lept_parse_field(r, obj);
+    if (ret == LEPT_PARSE_OK)
+    {
+        lept_parse_whitespace(r);
+        if (r.json != r.end)
+            ret = LEPT_PARSE_ROOT_NOT_SINGULAR;
+    }
+    else if (ret == LEPT_PARSE_TYPE_MISMATCH || ret == LEPT_PARSE_NUMBER_TOO_BIG)
+    { // 只在出错时发生：之后的文本还没有校验，其中的语法错误优先
+        lept_parse_ret syntax = lept_bind_check(json, len, options);
+        if (syntax != LEPT_PARSE_OK)
+            ret = syntax;
+    }
+    return ret;
+}
+
+template <typename T>
+lept_parse_ret lept_parse_into(T &obj, const char *json, const lept_parse_options &options = lept_parse_options())
+{
+    return lept_parse_into(obj, json, strlen(json), options);
+}
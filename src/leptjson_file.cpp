@@ -0,0 +1,111 @@
+#include "leptjson.h"
+#include "leptjson_internal.h"
+#ifdef _WIN32
+#include <cstdio>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+/* 没有 mmap 时整个读入内存，行为与映射相同 */
+
+bool lept_map_file(const char *path, char *&data, size_t &size)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return false;
+    bool ok = fseek(f, 0, SEEK_END) == 0;
+    long n = ok ? ftell(f) : -1;
+    ok = n >= 0 && fseek(f, 0, SEEK_SET) == 0;
+    data = NULL;
+    size = ok ? (size_t)n : 0;
+    if (ok && size)
+    {
+        data = new char[size];
+        if (fread(data, 1, size, f) != size)
+        {
+            delete[] data;
+            data = NULL;
+            ok = false;
+        }
+    }
+    fclose(f);
+    return ok;
+}
+
+void lept_unmap_file(char *data, size_t)
+{
+    delete[] data;
+}
+#else
+bool lept_map_file(const char *path, char *&data, size_t &size)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    data = NULL;
+    size = (size_t)st.st_size;
+    if (size)
+    { // MAP_PRIVATE：引用模式在映射中原地解码只会复制被改写的页，不会改动文件
+        void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED)
+        {
+            close(fd);
+            return false;
+        }
+        madvise(p, size, MADV_SEQUENTIAL); // 只是提示，失败无妨
+        data = (char *)p;
+    }
+    close(fd); // 映射在关闭文件后仍然有效
+    return true;
+}
+
+void lept_unmap_file(char *data, size_t size)
+{
+    if (data)
+        munmap(data, size);
+}
+#endif
+
+lept_parse_ret lept_value::lept_parse_file(lept_value &v, const char *path, const lept_parse_options &options)
+{
+    char *data;
+    size_t size;
+    if (!lept_map_file(path, data, size))
+        return LEPT_PARSE_IO_ERROR;
+    lept_parse_ret ret = lept_parse(v, data, size, options);
+    lept_unmap_file(data, size);
+    return ret;
+}
+
+lept_parse_ret lept_document::lept_parse_file(const char *path, lept_file_mode mode)
+{
+    lept_reset();
+    char *data;
+    size_t size;
+    if (!lept_map_file(path, data, size))
+        return LEPT_PARSE_IO_ERROR;
+
+    lept_context &c = lept_get_context(data, size);
+    c.insitu = mode == LEPT_FILE_REFERENCE;
+    c.symbols = c.insitu ? NULL : symbols;
+    lept_parse_ret ret = lept_parse_tree(c, root, options);
+    if (c.insitu && ret == LEPT_PARSE_OK)
+    {
+        map = data;
+        map_size = size;
+    }
+    else
+        lept_unmap_file(data, size);
+    return ret;
+}
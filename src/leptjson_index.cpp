@@ -0,0 +1,352 @@
+#include "leptjson.h"
+#include "leptjson_internal.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+/*
+ * 结构索引引擎
+ * 第一阶段每次处理 64 字节：先得到引号、反斜杠、控制字符、空白与运算符的位图，再用位运算算出被转义的字符
+ * 与字符串所占的区域，最后记下字符串外的运算符、字符串两端的引号、字符串中的反斜杠与控制字符，以及每段字面量
+ * 或数字开头的位置。索引保存在上下文中，复用同一上下文（如 lept_document）的各次解析不再为它分配内存。
+ * 第二阶段按索引项处的字节直接分派：紧跟在开头引号之后的索引项就是闭合的引号时，字符串没有转义也没有非法字符，
+ * 内容直接取自两个引号之间，否则才交给原有的字符串解析函数；记号之间的空白不再逐字节跳过，下一个记号就是下一个索引项。
+ * 容器用显式的栈，不会递归。
+ */
+
+void lept_classify_block_scalar(const char *p, lept_block_masks &m)
+{
+    m.quote = m.backslash = m.ctrl = m.ws = m.op = 0;
+    for (int i = 0; i < 64; i++)
+    {
+        uint64_t bit = (uint64_t)1 << i;
+        if ((unsigned char)p[i] < 0x20)
+            m.ctrl |= bit;
+        switch (p[i])
+        {
+        case '"':
+            m.quote |= bit;
+            break;
+        case '\\':
+            m.backslash |= bit;
+            break;
+        case ' ':
+        case '\t':
+        case '\n':
+        case '\r':
+            m.ws |= bit;
+            break;
+        case '[':
+        case ']':
+        case '{':
+        case '}':
+        case ':':
+        case ',':
+            m.op |= bit;
+            break;
+        }
+    }
+}
+
+#ifdef LEPT_X86_SIMD
+/* SSE2 没有查表指令：'[' 与 '{'、']' 与 '}' 只差 0x20 这一位，或上 0x20 后各用一次比较 */
+
+__attribute__((target("sse2"))) void lept_classify_block_sse2(const char *p, lept_block_masks &m)
+{
+    m.quote = m.backslash = m.ctrl = m.ws = m.op = 0;
+    for (int i = 0; i < 64; i += 16)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)(p + i));
+        __m128i lower = _mm_or_si128(x, _mm_set1_epi8(0x20));
+        __m128i ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(' ')),
+                                               _mm_cmpeq_epi8(x, _mm_set1_epi8('\t'))),
+                                  _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('\n')),
+                                               _mm_cmpeq_epi8(x, _mm_set1_epi8('\r'))));
+        __m128i op = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(lower, _mm_set1_epi8('{')),
+                                               _mm_cmpeq_epi8(lower, _mm_set1_epi8('}'))),
+                                  _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(':')),
+                                               _mm_cmpeq_epi8(x, _mm_set1_epi8(','))));
+        m.quote |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_set1_epi8('"'))) << i;
+        m.backslash |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_set1_epi8('\\'))) << i;
+        m.ctrl |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(x, _mm_set1_epi8(0x1F)), x)) << i;
+        m.ws |= (uint64_t)(uint16_t)_mm_movemask_epi8(ws) << i;
+        m.op |= (uint64_t)(uint16_t)_mm_movemask_epi8(op) << i;
+    }
+}
+
+/*
+ * AVX2 按高低两个半字节各查一次表再相与：低 3 位表示运算符，第 3、4 位表示空白，
+ * 只有这 10 个字符的两次查表结果有公共的位；最高位为 1 的字节高半字节查到 0
+ */
+__attribute__((target("avx2"))) void lept_classify_block_avx2(const char *p, lept_block_masks &m)
+{
+    const __m256i lo_table = _mm256_setr_epi8(16, 0, 0, 0, 0, 0, 0, 0, 0, 8, 12, 1, 2, 9, 0, 0, //
+                                              16, 0, 0, 0, 0, 0, 0, 0, 0, 8, 12, 1, 2, 9, 0, 0);
+    const __m256i hi_table = _mm256_setr_epi8(8, 0, 18, 4, 0, 1, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, //
+                                              8, 0, 18, 4, 0, 1, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i nibble = _mm256_set1_epi8(0x0F), zero = _mm256_setzero_si256();
+    m.quote = m.backslash = m.ctrl = m.ws = m.op = 0;
+    for (int i = 0; i < 64; i += 32)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(p + i));
+        __m256i lo = _mm256_shuffle_epi8(lo_table, _mm256_and_si256(x, nibble));
+        __m256i hi = _mm256_shuffle_epi8(hi_table, _mm256_and_si256(_mm256_srli_epi16(x, 4), nibble));
+        __m256i c = _mm256_and_si256(lo, hi);
+        __m256i not_op = _mm256_cmpeq_epi8(_mm256_and_si256(c, _mm256_set1_epi8(7)), zero);
+        __m256i not_ws = _mm256_cmpeq_epi8(_mm256_and_si256(c, _mm256_set1_epi8(0x18)), zero);
+        m.quote |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('"'))) << i;
+        m.backslash |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('\\'))) << i;
+        m.ctrl |= (uint64_t)(uint32_t)_mm256_movemask_epi8(
+                      _mm256_cmpeq_epi8(_mm256_min_epu8(x, _mm256_set1_epi8(0x1F)), x))
+                  << i;
+        m.ws |= (uint64_t)(uint32_t)~_mm256_movemask_epi8(not_ws) << i;
+        m.op |= (uint64_t)(uint32_t)~_mm256_movemask_epi8(not_op) << i;
+    }
+}
+#endif
+
+std::atomic<void (*)(const char *, lept_block_masks &)> lept_classify_block_impl(lept_classify_block_scalar); // 按级别选择的实现
+
+/* 反斜杠很少，逐个处理 */
+uint64_t lept_find_escaped(uint64_t backslash, lept_index_carry &carry)
+{
+    uint64_t escaped = carry.escaped;
+    carry.escaped = 0;
+    backslash &= ~escaped; // 被转义的反斜杠不再转义后一个字符
+    while (backslash)
+    {
+        int i = __builtin_ctzll(backslash);
+        uint64_t next = i == 63 ? 0 : (uint64_t)1 << (i + 1);
+        if (i == 63)
+            carry.escaped = 1;
+        escaped |= next;
+        backslash &= ~((uint64_t)1 << i) & ~next;
+    }
+    return escaped;
+}
+
+uint64_t lept_prefix_xor(uint64_t x)
+{
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+/** 一个块中需要进入索引的位置；在各级别的 lept_index_blocks 中展开，分类函数随之内联 */
+template <void (*Classify)(const char *, lept_block_masks &)>
+inline __attribute__((always_inline)) uint64_t lept_find_structurals(const char *p, lept_index_carry &carry)
+{
+    lept_block_masks m;
+    Classify(p, m);
+
+    uint64_t quote = m.quote & ~lept_find_escaped(m.backslash, carry);
+    uint64_t in_string = lept_prefix_xor(quote) ^ carry.in_string; // 含开头的引号，不含闭合的引号
+    carry.in_string = (uint64_t)((int64_t)in_string >> 63);
+
+    uint64_t scalar = ~(m.ws | m.op | quote | in_string); // 字符串外的字面量与数字
+    uint64_t scalar_start = scalar & ~((scalar << 1) | carry.scalar);
+    carry.scalar = scalar >> 63;
+
+    return (m.op & ~in_string) | quote | ((m.backslash | m.ctrl) & in_string) | scalar_start;
+}
+
+/** 为 [p, p + len) 中的各块建立索引，len 为 64 的倍数，偏移从 base 算起，返回写完后的位置 */
+template <void (*Classify)(const char *, lept_block_masks &)>
+inline __attribute__((always_inline)) uint32_t *lept_index_blocks(const char *p, size_t len, size_t base,
+                                                                   lept_index_carry &carry, uint32_t *out)
+{
+    for (size_t i = 0; i < len; i += 64)
+        for (uint64_t s = lept_find_structurals<Classify>(p + i, carry); s; s &= s - 1)
+            *out++ = (uint32_t)(base + i + __builtin_ctzll(s));
+    return out;
+}
+
+uint32_t *lept_index_blocks_scalar(const char *p, size_t len, size_t base, lept_index_carry &carry, uint32_t *out)
+{
+    return lept_index_blocks<lept_classify_block_scalar>(p, len, base, carry, out);
+}
+
+#ifdef LEPT_X86_SIMD
+__attribute__((target("sse2"))) uint32_t *lept_index_blocks_sse2(const char *p, size_t len, size_t base,
+                                                                 lept_index_carry &carry, uint32_t *out)
+{
+    return lept_index_blocks<lept_classify_block_sse2>(p, len, base, carry, out);
+}
+
+__attribute__((target("avx2"))) uint32_t *lept_index_blocks_avx2(const char *p, size_t len, size_t base,
+                                                                 lept_index_carry &carry, uint32_t *out)
+{
+    return lept_index_blocks<lept_classify_block_avx2>(p, len, base, carry, out);
+}
+#endif
+
+std::atomic<uint32_t *(*)(const char *, size_t, size_t, lept_index_carry &, uint32_t *)> lept_index_blocks_impl(
+    lept_index_blocks_scalar); // 按级别选择的实现
+
+/** 第一阶段：把 [json, json + len) 中所有结构字符的偏移记入 index，最后一项为 len，返回首项的位置 */
+const uint32_t *lept_index_structurals(const char *json, size_t len, std::vector<uint32_t> &index)
+{
+    const size_t chunk = 64 * 1024; // 每段至多产生 chunk 项，写入前确认索引放得下
+    auto index_blocks = lept_index_blocks_impl.load(std::memory_order_relaxed);
+    lept_index_carry carry = {0, 0, 0};
+    size_t n = 0;
+    if (index.empty()) // 空的输入也要放下最后一项
+        index.resize(64 + 1);
+    for (size_t base = 0; base < len; base += chunk)
+    {
+        size_t size = len - base < chunk ? len - base : chunk;
+        if (index.size() < n + size + 64 + 1) // 只在复用的缓冲不够大时增长，不随每次解析清空
+            index.resize(std::max(index.size() * 2, n + size + 64 + 1));
+        uint32_t *out = index_blocks(json + base, size & ~(size_t)63, base, carry, index.data() + n);
+        if (size % 64)
+        { // 最后不足一块的部分补上空白
+            char tail[64];
+            memset(tail, ' ', sizeof(tail));
+            memcpy(tail, json + base + (size & ~(size_t)63), size % 64);
+            out = index_blocks(tail, 64, base + (size & ~(size_t)63), carry, out);
+        }
+        n = out - index.data();
+    }
+    index[n] = (uint32_t)len;
+    return index.data();
+}
+
+/**
+ * 解析 p 处的字符串，index 指向开头引号之后的索引项，完成后指向闭合引号之后的一项；
+ * 紧接着的索引项就是闭合的引号时内容直接取自输入，否则交给 lept_parse_string_raw
+ */
+lept_parse_ret lept_index_string(lept_context &c, const char *begin, const char *p, const uint32_t *&index,
+                                 const char *&s, size_t &len)
+{
+    const char *q = begin + *index;
+    if (q < c.end && *q == '"')
+    {
+        LEPT_STATS_TIME(string_ns);
+        s = p + 1;
+        len = q - s;
+        if (c.insitu) // 与 lept_parse_string_insitu 一样以 '\0' 结尾
+            *const_cast<char *>(q) = '\0';
+        LEPT_STATS_ADD(string_bytes, len);
+        index++;
+        return LEPT_PARSE_OK;
+    }
+    c.json = p; // 含转义或非法字符，或者没有闭合
+    lept_parse_ret ret = lept_parse_string_raw(c, s, len);
+    while (begin + *index < c.json) // 跳过字符串中的反斜杠与控制字符；最后一项为末尾，一定会停下
+        index++;
+    return ret;
+}
+
+/** 第二阶段 */
+lept_parse_ret lept_parse_indexed(lept_context &c, lept_value &v)
+{
+    const char *begin = c.json, *end = c.end;
+    const uint32_t *index = lept_index_structurals(begin, end - begin, c.index);
+    lept_value_handler h = {c};
+    std::vector<lept_reader_frame> &frames = c.frames;
+    frames.clear();
+    lept_parse_ret ret;
+    const char *s, *p = begin + *index++;
+    size_t len;
+
+value: // p 处应当是一个值
+    if (p == end)
+        return LEPT_PARSE_EXPECT_VALUE;
+    switch (*p)
+    {
+    case '"':
+        if ((ret = lept_index_string(c, begin, p, index, s, len)) != LEPT_PARSE_OK)
+            return ret;
+        h.lept_string(s, len);
+        p = begin + *index++; // 闭合的引号与下一项之间只有空白
+        goto after_value;
+    case '[':
+    case '{': {
+        if (frames.size() >= c.max_depth)
+            return LEPT_PARSE_TOO_DEEP;
+        bool object = *p == '{';
+        if (object)
+            h.lept_start_object();
+        else
+            h.lept_start_array();
+        p = begin + *index++;
+        if (p < end && *p == (object ? '}' : ']'))
+        {
+            if (object)
+                h.lept_end_object(0);
+            else
+                h.lept_end_array(0);
+            p = begin + *index++;
+            goto after_value;
+        }
+        frames.push_back({1, object});
+        if (object)
+            goto key;
+        goto value;
+    }
+    default: { // 数字或字面量
+        c.json = p;
+        if ((ret = lept_parse_scalar(c, h)) != LEPT_PARSE_OK)
+            return ret;
+        /*
+         * 记号之后是空白时，到下一项之间都是空白：其中任何别的字节都会是结构字符或新一段字面量的开头而进入索引；
+         * 否则记号后面紧跟着同一段中的多余字节，留给 after_value 报错
+         */
+        const char *q = begin + *index;
+        if (c.json == q || *c.json == ' ' || *c.json == '\t' || *c.json == '\n' || *c.json == '\r')
+        {
+            p = q;
+            index++;
+        }
+        else
+            p = c.json;
+        goto after_value;
+    }
+    }
+
+key: // p 处应当是对象的键
+    if (p == end || *p != '"')
+        return LEPT_PARSE_MISS_KEY;
+    if ((ret = lept_index_string(c, begin, p, index, s, len)) != LEPT_PARSE_OK)
+        return ret;
+    h.lept_key(s, len);
+    p = begin + *index++;
+    if (p == end || *p != ':')
+        return LEPT_PARSE_MISS_COLON;
+    p = begin + *index++;
+    goto value;
+
+after_value: // p 是值之后的第一个非空白字符
+    if (frames.empty())
+    {
+        if (p != end)
+            return LEPT_PARSE_ROOT_NOT_SINGULAR;
+        v = std::move(c.values.back());
+        return LEPT_PARSE_OK;
+    }
+    if (p < end && *p == ',')
+    {
+        frames.back().n++;
+        p = begin + *index++;
+        if (frames.back().object)
+            goto key;
+        goto value;
+    }
+    if (p < end && *p == (frames.back().object ? '}' : ']'))
+    {
+        lept_reader_frame f = frames.back();
+        frames.pop_back();
+        if (f.object)
+            h.lept_end_object(f.n);
+        else
+            h.lept_end_array(f.n);
+        p = begin + *index++;
+        goto after_value;
+    }
+    return frames.back().object ? LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET : LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+}
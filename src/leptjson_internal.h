@@ -0,0 +1,356 @@
+#pragma once
+
+#include "leptjson.h"
+#include "leptjson_sax.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LEPT_X86_SIMD
+#include <immintrin.h>
+#endif
+
+/* 库内部各源文件共用的函数，不属于公开接口 */
+
+/*
+ * 解析统计的记录点
+ * 未定义 LEPT_STATS 时展开为空；定义时只在 lept_parse_tree 执行期间、且本线程设置了 lept_parse_stats 时记录
+ */
+#ifdef LEPT_STATS
+extern thread_local lept_parse_stats *lept_stats; // 正在构造树时为本线程的统计，否则为 NULL
+
+/** 在作用域结束时把经过的时间加到 *ns 上，ns 为 NULL 时不计时 */
+struct lept_stats_timer
+{
+    uint64_t *ns;
+    std::chrono::steady_clock::time_point t0;
+
+    explicit lept_stats_timer(uint64_t *ns) : ns(ns)
+    {
+        if (ns)
+            t0 = std::chrono::steady_clock::now();
+    }
+    ~lept_stats_timer()
+    {
+        if (ns)
+            *ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+    }
+};
+
+#define LEPT_STATS_ADD(field, n)                                                                                       \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (lept_stats)                                                                                                \
+            lept_stats->field += (n);                                                                                  \
+    } while (0)
+#define LEPT_STATS_TIME(field) lept_stats_timer lept_stats_timer_(lept_stats ? &lept_stats->field : NULL)
+#else
+#define LEPT_STATS_ADD(field, n) ((void)0)
+#define LEPT_STATS_TIME(field) ((void)0)
+#endif
+
+/**
+ * 文档的符号表：每个不同的键在 arena 中只存放一次，内容之前是 lept_symbol_head
+ * 对象的键引用这里的内容并带有 LEPT_FLAG_INTERNED，建立索引与按键查找时直接取用其中的散列值。
+ * 记录数组中的键总是以相同的顺序重复出现，因此先猜测上一个键之后还是上次跟在它后面的键，猜中时不必计算散列
+ */
+struct lept_symbols
+{
+    std::vector<char *> slots; // 开放寻址，线性探测，空槽为 NULL
+    size_t count = 0;
+    char *last = NULL; // 上一个驻留的键
+
+    char *lept_find(const char *k, size_t len, uint32_t h) const; // 没有时返回 NULL
+    char *lept_intern(const char *k, size_t len, lept_arena &arena); // 返回驻留的内容，以 '\0' 结尾
+    char *lept_insert(const char *k, size_t len, uint32_t h, lept_arena &arena); // 加入不在表中的键
+    void lept_clear();
+};
+
+/** 驻留的键内容之前的头部 */
+struct lept_symbol_head
+{
+    char *next; // 上次紧随这个键之后驻留的键
+    uint32_t len;
+    uint32_t hash;
+};
+
+/** 键的散列值（FNV-1a） */
+uint32_t lept_hash_key(const char *k, size_t len);
+
+struct lept_context : lept_reader // 构造树时的解析上下文
+{
+    lept_arena *arena = NULL;         // 节点内容的分配来源，为 NULL 时使用堆
+    lept_symbols *symbols = NULL;     // 非空时对象的键在其中驻留，须与 arena 同时使用
+    std::vector<lept_value> values;   // 尚未组装进数组或对象的值，对象的键与值交替存放
+    std::vector<lept_member> members; // 增量解析时尚未组装成对象的成员
+    std::vector<uint32_t> index;      // 结构索引引擎的索引，只增不减，复用上下文时不再分配
+    size_t object_index_min = lept_parse_options().object_index_min; // 见 lept_parse_options
+#ifdef LEPT_STATS
+    uint64_t depth = 0; // 当前的嵌套深度，只用于统计
+#endif
+};
+
+/** 多线程构造树时各线程独占的 arena 与上下文，lept_batch 与 lept_document 各持有一份，在各次解析间复用 */
+struct lept_workers
+{
+    std::vector<std::unique_ptr<lept_arena>> arenas; // 每个线程一个，分配互不争用
+    std::vector<lept_context> contexts;              // 每个线程一个，栈与索引不必每次重新分配
+
+    void lept_reserve(unsigned threads); // 至少备好 threads 个线程的份
+    void lept_clear();                   // 归还各 arena 中的内容
+    size_t lept_get_used_size() const;   // 各 arena 中分配出去的字节数
+};
+
+/** 将 v 置为长度为 len 的字符串，内容复制自 s；arena 非空时从中分配并标记为不持有内容 */
+void lept_set_string_raw(lept_value &v, const char *s, size_t len, lept_arena *arena = NULL);
+
+/** 将 v 置为引用 s 的字符串，s[len] 须为 '\0'，v 不持有内容 */
+void lept_set_string_ref(lept_value &v, char *s, size_t len);
+
+/** 将 v 置为驻留在符号表中的键 s，v 不持有内容 */
+void lept_set_symbol(lept_value &v, char *s);
+
+/** 将 v 置为数组或对象，元素、成员从 e、m 中移动过来 */
+void lept_set_array_raw(lept_value &v, lept_value *e, size_t n, lept_arena *arena = NULL);
+/** 成员数不少于 index_min（非 0）时为对象建立散列索引并标记 LEPT_FLAG_INDEXED */
+void lept_set_object_raw(lept_value &v, lept_member *m, size_t n, lept_arena *arena, size_t index_min);
+void lept_set_object_pairs(lept_value &v, lept_value *kv, size_t n, lept_arena *arena, size_t index_min); // 键值交替存放
+
+/**
+ * 按 SIMD 级别选择的实现，lept_set_simd_level 可能在其他线程解析时改变它们，因此以原子变量保存；
+ * 每次调用时以 relaxed 方式读取，各实现的结果相同，一次解析中途切换也无妨
+ */
+extern std::atomic<const char *(*)(const char *, const char *)> lept_scan_string_impl;
+
+/** 找到 [p, end) 中第一个 '"'、'\\' 或控制字符，没有时返回 end；实现按 SIMD 级别选择 */
+inline const char *lept_scan_string(const char *p, const char *end)
+{
+    return lept_scan_string_impl.load(std::memory_order_relaxed)(p, end);
+}
+
+/** 64 字节块中各类字符的位图，第 i 位对应第 i 个字节 */
+struct lept_block_masks
+{
+    uint64_t quote;     // '"'
+    uint64_t backslash; // '\\'
+    uint64_t ctrl;      // 小于 0x20 的控制字符
+    uint64_t ws;        // 空白
+    uint64_t op;        // [ ] { } : ,
+};
+
+/** 对 p 开始的 64 个字节分类；实现按 SIMD 级别选择 */
+void lept_classify_block_scalar(const char *p, lept_block_masks &m);
+#ifdef LEPT_X86_SIMD
+void lept_classify_block_sse2(const char *p, lept_block_masks &m);
+void lept_classify_block_avx2(const char *p, lept_block_masks &m);
+#endif
+extern std::atomic<void (*)(const char *, lept_block_masks &)> lept_classify_block_impl;
+
+inline void lept_classify_block(const char *p, lept_block_masks &m)
+{
+    lept_classify_block_impl.load(std::memory_order_relaxed)(p, m);
+}
+
+/** 逐块扫描时块与块之间传递的状态 */
+struct lept_index_carry
+{
+    uint64_t escaped;   // 下一块的第 0 位被上一块末尾的 '\\' 转义
+    uint64_t in_string; // 上一块结束时位于字符串中，为全 1 或全 0
+    uint64_t scalar;    // 上一块的最后一个字节属于字面量或数字
+};
+
+/** 块中被转义的字符 */
+uint64_t lept_find_escaped(uint64_t backslash, lept_index_carry &carry);
+
+/** 前缀异或：第 i 位为 x 第 0 到 i 位的异或，由引号的位图得到字符串所占的区域 */
+uint64_t lept_prefix_xor(uint64_t x);
+
+/** 结构索引的第一阶段：为 [p, p + len) 中的各块记下结构字符的偏移，len 为 64 的倍数；实现按 SIMD 级别选择 */
+uint32_t *lept_index_blocks_scalar(const char *p, size_t len, size_t base, lept_index_carry &carry, uint32_t *out);
+#ifdef LEPT_X86_SIMD
+uint32_t *lept_index_blocks_sse2(const char *p, size_t len, size_t base, lept_index_carry &carry, uint32_t *out);
+uint32_t *lept_index_blocks_avx2(const char *p, size_t len, size_t base, lept_index_carry &carry, uint32_t *out);
+#endif
+extern std::atomic<uint32_t *(*)(const char *, size_t, size_t, lept_index_carry &, uint32_t *)> lept_index_blocks_impl;
+
+/** 构造 lept_value 树的事件处理器，值依次压入 c.values，数组与对象闭合时从栈顶取出组装 */
+struct lept_value_handler
+{
+    lept_context &c;
+
+    lept_value &lept_push()
+    {
+        c.values.emplace_back();
+        return c.values.back();
+    }
+    void lept_null()
+    {
+        LEPT_STATS_ADD(nodes[LEPT_NULL], 1);
+        lept_push();
+    }
+    void lept_boolean(bool b)
+    {
+        LEPT_STATS_ADD(nodes[b ? LEPT_TRUE : LEPT_FALSE], 1);
+        lept_push().lept_set_boolean(b);
+    }
+    void lept_number(double n)
+    {
+        LEPT_STATS_ADD(nodes[LEPT_NUMBER], 1);
+        lept_push().lept_set_number(n);
+    }
+    void lept_int64(int64_t i)
+    {
+        LEPT_STATS_ADD(nodes[LEPT_NUMBER], 1);
+        lept_push().lept_set_int64(i);
+    }
+    void lept_uint64(uint64_t u)
+    {
+        LEPT_STATS_ADD(nodes[LEPT_NUMBER], 1);
+        lept_push().lept_set_uint64(u);
+    }
+    void lept_push_string(const char *s, size_t len)
+    {
+        if (c.insitu) // s 指向已原地解码的输入
+            lept_set_string_ref(lept_push(), const_cast<char *>(s), len);
+        else
+            lept_set_string_raw(lept_push(), s, len, c.arena);
+    }
+    void lept_string(const char *s, size_t len)
+    {
+        LEPT_STATS_ADD(nodes[LEPT_STRING], 1);
+        lept_push_string(s, len);
+    }
+    void lept_key(const char *s, size_t len)
+    {
+        if (c.symbols)
+            lept_set_symbol(lept_push(), c.symbols->lept_intern(s, len, *c.arena));
+        else
+            lept_push_string(s, len);
+    }
+    void lept_enter() // 进入数组或对象
+    {
+#ifdef LEPT_STATS
+        if (lept_stats && ++c.depth > lept_stats->max_depth)
+            lept_stats->max_depth = c.depth;
+#endif
+    }
+    void lept_leave(lept_type type) // 离开数组或对象
+    {
+#ifdef LEPT_STATS
+        if (lept_stats)
+        {
+            lept_stats->nodes[type]++;
+            c.depth--;
+        }
+#else
+        (void)type;
+#endif
+    }
+    void lept_start_array()
+    {
+        lept_enter();
+    }
+    void lept_end_array(size_t n)
+    {
+        lept_leave(LEPT_ARRAY);
+        lept_value v;
+        lept_set_array_raw(v, c.values.data() + c.values.size() - n, n, c.arena);
+        c.values.resize(c.values.size() - n);
+        c.values.push_back(std::move(v));
+    }
+    void lept_start_object()
+    {
+        lept_enter();
+    }
+    void lept_end_object(size_t n)
+    {
+        lept_leave(LEPT_OBJECT);
+        lept_value v;
+        lept_set_object_pairs(v, c.values.data() + c.values.size() - n * 2, n, c.arena, c.object_index_min);
+        c.values.resize(c.values.size() - n * 2);
+        c.values.push_back(std::move(v));
+    }
+};
+
+/** 由十进制有效数字 w 与指数 e10 计算 (neg ? -1 : 1) * w * 10^e10 最接近的 double，无法确定正确舍入时返回 false */
+bool lept_eisel_lemire(uint64_t w, int e10, bool neg, double &d);
+
+/** 与区域设置无关的 strtod，s 须为合法的 json 数字并以 '\0' 结尾 */
+double lept_strtod_c(const char *s);
+
+/** 将有限的 d 写为能精确解析回 d 的最短（或接近最短）的 json 数字，最多写 25 个字符，返回写入的末尾 */
+char *lept_dtoa(double d, char *buffer);
+
+/** 将整数写为十进制，最多写 20 个字符，返回写入的末尾 */
+char *lept_i64toa(int64_t i, char *buffer);
+char *lept_u64toa(uint64_t u, char *buffer);
+
+/**
+ * 释放、拷贝、序列化与编码树时代替递归的栈
+ * 前 N 层放在自身的数组中，更深的部分才放到堆上，处理常见深度的树时不为栈分配内存
+ */
+template <typename T, size_t N = 32> struct lept_walk_stack
+{
+    T local[N];
+    std::vector<T> spill; // 第 N 层之后的帧
+    size_t n = 0;
+
+    bool empty() const
+    {
+        return n == 0;
+    }
+    size_t size() const
+    {
+        return n;
+    }
+    T &back()
+    {
+        return n <= N ? local[n - 1] : spill.back();
+    }
+    void push_back(const T &f)
+    {
+        if (n < N)
+            local[n] = f;
+        else
+            spill.push_back(f);
+        n++;
+    }
+    void pop_back()
+    {
+        if (n > N)
+            spill.pop_back();
+        n--;
+    }
+};
+
+/** 在上下文 c 中按 options 解析一个完整的 json 文本，构造出的树移动到 v 中 */
+lept_parse_ret lept_parse_tree(lept_context &c, lept_value &v, const lept_parse_options &options);
+
+/** 用结构索引引擎完成 lept_parse_tree，输入须短于 4GB；索引存放在 c.index 中 */
+lept_parse_ret lept_parse_indexed(lept_context &c, lept_value &v);
+
+/**
+ * 用 threads 个线程（含调用者所在线程）处理 [0, n)：各线程每次领取至多 grain 个下标，调用 f(worker, begin, end)，
+ * worker 为 [0, threads) 中的线程编号；全部完成后返回，线程中抛出的第一个异常在返回前重新抛出。
+ * 其余线程取自进程内共享的线程池，不随每次调用创建；线程池正被占用时（如在 f 中再次调用）改用临时创建的线程
+ */
+void lept_parallel_for(unsigned threads, size_t n, size_t grain,
+                       const std::function<void(unsigned worker, size_t begin, size_t end)> &f);
+
+/** threads 为 0 时取硬件线程数 */
+unsigned lept_resolve_threads(unsigned threads);
+
+/** 以可写、修改不写回的方式映射整个文件，空文件得到 data 为 NULL；失败时返回 false */
+bool lept_map_file(const char *path, char *&data, size_t &size);
+void lept_unmap_file(char *data, size_t size); // data 为 NULL 时什么也不做
+
+/* 按需访问时跳过值而不解码，实现见 leptjson_lazy.cpp */
+const char *lept_skip_whitespace(const char *p, const char *end);
+const char *lept_skip_string(const char *p, const char *end);                     // p 在 '"' 之后，没有闭合时返回 NULL
+const char *lept_skip_value(const char *p, const char *end, lept_parse_ret &ret); // 出错时返回 NULL 并设置 ret
+bool lept_lazy_key_equal(lept_reader &r, const char *q, const char *k, size_t len); // r.json 为键的 '"'，q 为其后第一个 '"'、'\\' 或控制字符
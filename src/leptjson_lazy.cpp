@@ -0,0 +1,269 @@
+#include "leptjson.h"
+#include "leptjson_internal.h"
+#include <cstring>
+#include <utility>
+
+/** 跳过空白 */
+const char *lept_skip_whitespace(const char *p, const char *end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+        p++;
+    return p;
+}
+
+/** 跳过 p 处（'"' 之后）的字符串内容，返回闭合的 '"' 之后，转义只跳过不校验；没有闭合时返回 NULL */
+const char *lept_skip_string(const char *p, const char *end)
+{
+    while (true)
+    {
+        p = lept_scan_string(p, end);
+        if (p == end)
+            return NULL;
+        if (*p == '"')
+            return p + 1;
+        if (*p == '\\' && ++p == end)
+            return NULL;
+        p++; // 转义的字符或控制字符
+    }
+}
+
+/** 跳过 p 处的一个值，只做括号匹配，不解码也不校验其中的字面量与数字；出错时返回 NULL 并设置 ret */
+const char *lept_skip_value(const char *p, const char *end, lept_parse_ret &ret)
+{
+    if (p == end)
+    {
+        ret = LEPT_PARSE_EXPECT_VALUE;
+        return NULL;
+    }
+    if (*p == '"')
+    {
+        if (!(p = lept_skip_string(p + 1, end)))
+            ret = LEPT_PARSE_MISS_QUOTATION_MARK;
+        return p;
+    }
+    if (*p != '[' && *p != '{')
+    { // 字面量或数字
+        const char *q = p;
+        while (q < end && ((*q >= '0' && *q <= '9') || (*q >= 'a' && *q <= 'z') || *q == '-' || *q == '+' ||
+                           *q == '.' || *q == 'E'))
+            q++;
+        if (q == p)
+        {
+            ret = LEPT_PARSE_INVALID_VALUE;
+            return NULL;
+        }
+        return q;
+    }
+
+    char outer = *p;
+    size_t depth = 0;
+    for (; p < end; p++)
+    {
+        switch (*p)
+        {
+        case '"':
+            if (!(p = lept_skip_string(p + 1, end)))
+            {
+                ret = LEPT_PARSE_MISS_QUOTATION_MARK;
+                return NULL;
+            }
+            p--;
+            break;
+        case '[':
+        case '{':
+            depth++;
+            break;
+        case ']':
+        case '}':
+            if (--depth == 0)
+                return p + 1;
+            break;
+        }
+    }
+    ret = outer == '[' ? LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET : LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+    return NULL;
+}
+
+lept_lazy_value::lept_lazy_value() : json(NULL), end(NULL), ret(LEPT_PARSE_OK)
+{
+}
+
+lept_lazy_value lept_lazy_value::lept_parse(const char *json, size_t len)
+{
+    lept_lazy_value v;
+    v.end = json + len;
+    v.json = lept_skip_whitespace(json, v.end);
+    if (v.json == v.end)
+    {
+        v.json = NULL;
+        v.ret = LEPT_PARSE_EXPECT_VALUE;
+    }
+    return v;
+}
+
+lept_lazy_value lept_lazy_value::lept_parse(const char *json)
+{
+    return lept_parse(json, strlen(json));
+}
+
+bool lept_lazy_value::lept_is_valid() const
+{
+    return json != NULL;
+}
+
+lept_parse_ret lept_lazy_value::lept_get_error() const
+{
+    return ret;
+}
+
+lept_type lept_lazy_value::lept_get_type() const
+{
+    if (!json)
+        return LEPT_NULL;
+    switch (*json)
+    {
+    case 'n':
+        return LEPT_NULL;
+    case 'f':
+        return LEPT_FALSE;
+    case 't':
+        return LEPT_TRUE;
+    case '"':
+        return LEPT_STRING;
+    case '[':
+        return LEPT_ARRAY;
+    case '{':
+        return LEPT_OBJECT;
+    default:
+        return LEPT_NUMBER;
+    }
+}
+
+/** 键是否等于 k；不含转义的键直接比较原文，否则解码后比较 */
+bool lept_lazy_key_equal(lept_reader &r, const char *q, const char *k, size_t len)
+{
+    const char *p = r.json + 1;
+    if (*q == '"')
+        return (size_t)(q - p) == len && memcmp(p, k, len) == 0;
+    const char *s;
+    size_t n;
+    return lept_parse_string_raw(r, s, n) == LEPT_PARSE_OK && n == len && memcmp(s, k, len) == 0;
+}
+
+lept_lazy_value lept_lazy_value::lept_find_object_value(const char *k, size_t len) const
+{
+    lept_lazy_value v;
+    v.end = end;
+    v.ret = ret;
+    if (lept_get_type() != LEPT_OBJECT)
+        return v;
+
+    lept_reader r; // 只在键含转义时用来解码
+    const char *p = lept_skip_whitespace(json + 1, end);
+    if (p < end && *p == '}')
+        return v;
+    while (true)
+    {
+        if (p == end || *p != '"')
+        {
+            v.ret = LEPT_PARSE_MISS_KEY;
+            return v;
+        }
+        const char *q = lept_scan_string(p + 1, end); // 第一个 '"'、'\\' 或控制字符
+        r.json = p;
+        r.end = end;
+        bool match = q < end && lept_lazy_key_equal(r, q, k, len);
+        if (!(p = lept_skip_string(p + 1, end)))
+        {
+            v.ret = LEPT_PARSE_MISS_QUOTATION_MARK;
+            return v;
+        }
+
+        p = lept_skip_whitespace(p, end);
+        if (p == end || *p != ':')
+        {
+            v.ret = LEPT_PARSE_MISS_COLON;
+            return v;
+        }
+        p = lept_skip_whitespace(p + 1, end);
+        if (match)
+        {
+            if (p == end)
+                v.ret = LEPT_PARSE_EXPECT_VALUE;
+            else
+                v.json = p;
+            return v;
+        }
+
+        if (!(p = lept_skip_value(p, end, v.ret)))
+            return v;
+        p = lept_skip_whitespace(p, end);
+        if (p < end && *p == ',')
+            p = lept_skip_whitespace(p + 1, end);
+        else if (p < end && *p == '}')
+            return v;
+        else
+        {
+            v.ret = LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+            return v;
+        }
+    }
+}
+
+lept_lazy_value lept_lazy_value::lept_find_object_value(const char *k) const
+{
+    return lept_find_object_value(k, strlen(k));
+}
+
+lept_lazy_value lept_lazy_value::lept_array_at(size_t index) const
+{
+    lept_lazy_value v;
+    v.end = end;
+    v.ret = ret;
+    if (lept_get_type() != LEPT_ARRAY)
+        return v;
+
+    const char *p = lept_skip_whitespace(json + 1, end);
+    if (p < end && *p == ']')
+        return v;
+    for (size_t i = 0;; i++)
+    {
+        if (i == index)
+        {
+            if (p == end)
+                v.ret = LEPT_PARSE_EXPECT_VALUE;
+            else
+                v.json = p;
+            return v;
+        }
+
+        if (!(p = lept_skip_value(p, end, v.ret)))
+            return v;
+        p = lept_skip_whitespace(p, end);
+        if (p < end && *p == ',')
+            p = lept_skip_whitespace(p + 1, end);
+        else if (p < end && *p == ']')
+            return v;
+        else
+        {
+            v.ret = LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+            return v;
+        }
+    }
+}
+
+lept_parse_ret lept_lazy_value::lept_get_value(lept_value &v, const lept_parse_options &options) const
+{
+    if (!json)
+        return ret == LEPT_PARSE_OK ? LEPT_PARSE_INVALID_VALUE : ret;
+    lept_context c;
+    c.json = json;
+    c.end = end;
+    c.max_depth = options.max_depth;
+    c.object_index_min = options.object_index_min;
+    lept_value_handler h = {c};
+    lept_parse_ret r = lept_parse_value(c, h);
+    if (r == LEPT_PARSE_OK)
+        v = std::move(c.values.back());
+    return r;
+}
@@ -0,0 +1,465 @@
+#include "leptjson.h"
+#include "leptjson_internal.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+unsigned lept_resolve_threads(unsigned threads)
+{
+    if (threads)
+        return threads;
+    threads = std::thread::hardware_concurrency();
+    return threads ? threads : 1;
+}
+
+/**
+ * 进程内共享的线程池：线程在首次需要时创建，之后一直保留，空闲时在条件变量上等待。
+ * 同一时刻只执行一个任务，任务的第 0 份由调用者自己完成，其余各份由池中的线程各领取一份
+ */
+struct lept_thread_pool
+{
+    std::mutex busy; // 执行任务期间由调用者持有
+    std::mutex lock; // 保护以下各项
+    std::condition_variable wake, done;
+    std::vector<std::thread> threads;
+    const std::function<void(unsigned)> *job = NULL; // 当前的任务
+    unsigned next = 0, end = 0;                      // 尚未领取的份为 [next, end)
+    unsigned pending = 0;                            // 已领取或待领取、尚未完成的份数
+    uint64_t generation = 0;                         // 每个任务加一，同一线程在一个任务中只领取一份
+    bool stop = false;
+
+    ~lept_thread_pool()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stop = true;
+        }
+        wake.notify_all();
+        for (std::thread &t : threads)
+            t.join();
+    }
+
+    void lept_work()
+    {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> guard(lock);
+        for (;;)
+        {
+            wake.wait(guard, [&] { return stop || (generation != seen && next < end); });
+            if (stop)
+                return;
+            seen = generation;
+            unsigned worker = next++;
+            const std::function<void(unsigned)> &f = *job;
+            guard.unlock();
+            f(worker);
+            guard.lock();
+            if (--pending == 0)
+                done.notify_one();
+        }
+    }
+
+    /** 用 threads 个线程执行 f(0) 到 f(threads - 1)，f 不得抛出异常；线程池正被占用时返回 false */
+    bool lept_run(unsigned threads, const std::function<void(unsigned)> &f)
+    {
+        std::unique_lock<std::mutex> owner(busy, std::try_to_lock);
+        if (!owner.owns_lock())
+            return false;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            while (this->threads.size() < threads - 1)
+                this->threads.emplace_back(&lept_thread_pool::lept_work, this);
+            job = &f;
+            next = 1;
+            end = threads;
+            pending = threads - 1;
+            generation++;
+        }
+        wake.notify_all();
+        f(0);
+        std::unique_lock<std::mutex> guard(lock);
+        done.wait(guard, [&] { return pending == 0; });
+        job = NULL;
+        return true;
+    }
+};
+
+lept_thread_pool &lept_get_thread_pool()
+{
+    static lept_thread_pool pool;
+    return pool;
+}
+
+void lept_parallel_for(unsigned threads, size_t n, size_t grain,
+                       const std::function<void(unsigned worker, size_t begin, size_t end)> &f)
+{
+    if (grain == 0)
+        grain = 1;
+    if (threads > (n + grain - 1) / grain) // 多出的线程领不到任务
+        threads = (unsigned)((n + grain - 1) / grain);
+    if (threads <= 1)
+    {
+        if (n)
+            f(0, 0, n);
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    std::exception_ptr error;
+    std::mutex error_lock;
+    auto work = [&](unsigned worker) {
+        try
+        {
+            for (size_t begin; (begin = next.fetch_add(grain)) < n;)
+                f(worker, begin, n - begin < grain ? n : begin + grain);
+        }
+        catch (...)
+        {
+            next = n; // 其余线程领完手头的任务后停止
+            std::lock_guard<std::mutex> lock(error_lock);
+            if (!error)
+                error = std::current_exception();
+        }
+    };
+
+    if (!lept_get_thread_pool().lept_run(threads, work))
+    {
+        std::vector<std::thread> pool;
+        pool.reserve(threads - 1);
+        for (unsigned w = 1; w < threads; w++)
+            pool.emplace_back(work, w);
+        work(0);
+        for (std::thread &t : pool)
+            t.join();
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
+
+/************************************************************************************************ */
+
+void lept_workers::lept_reserve(unsigned threads)
+{
+    while (arenas.size() < threads)
+        arenas.emplace_back(new lept_arena);
+    if (contexts.size() < threads)
+        contexts.resize(threads);
+    for (unsigned w = 0; w < threads; w++)
+        contexts[w].arena = arenas[w].get();
+}
+
+void lept_workers::lept_clear()
+{
+    for (auto &arena : arenas)
+        arena->lept_clear();
+}
+
+size_t lept_workers::lept_get_used_size() const
+{
+    size_t used = 0;
+    for (auto &arena : arenas)
+        used += arena->lept_get_used_size();
+    return used;
+}
+
+/************************************************************************************************ */
+
+struct lept_batch_state
+{
+    unsigned threads; // 0 表示硬件线程数
+    lept_parse_options options;
+    lept_workers workers;
+    std::vector<size_t> offsets; // 各记录的起始位置
+    std::vector<lept_value> values;
+    std::vector<lept_parse_ret> rets;
+};
+
+/** 行中是否只有空白 */
+bool lept_is_blank(const char *p, const char *end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+        p++;
+    return p == end;
+}
+
+lept_batch::lept_batch(unsigned threads) : state(new lept_batch_state)
+{
+    state->threads = threads;
+}
+
+lept_batch::~lept_batch()
+{
+    delete state;
+}
+
+void lept_batch::lept_set_threads(unsigned threads)
+{
+    state->threads = threads;
+}
+
+unsigned lept_batch::lept_get_threads() const
+{
+    return lept_resolve_threads(state->threads);
+}
+
+void lept_batch::lept_set_options(const lept_parse_options &options)
+{
+    state->options = options;
+}
+
+size_t lept_batch::lept_parse_lines(const char *json, size_t len)
+{
+    lept_batch_state &s = *state;
+    s.values.clear(); // 旧内容都在 arena 中
+    s.workers.lept_clear();
+
+    // 只需找 '\n'，比解析快得多，留在调用线程中顺序完成
+    s.offsets.clear();
+    std::vector<size_t> ends;
+    for (const char *p = json, *end = json + len; p < end;)
+    {
+        const char *eol = (const char *)memchr(p, '\n', end - p);
+        if (!eol)
+            eol = end;
+        if (!lept_is_blank(p, eol))
+        {
+            s.offsets.push_back(p - json);
+            ends.push_back(eol - json);
+        }
+        p = eol + 1;
+    }
+
+    size_t n = s.offsets.size();
+    s.values.resize(n);
+    s.rets.assign(n, LEPT_PARSE_OK);
+    unsigned threads = lept_resolve_threads(s.threads);
+    s.workers.lept_reserve(threads);
+
+    lept_parallel_for(threads, n, 64, [&](unsigned worker, size_t begin, size_t end) {
+        lept_context &c = s.workers.contexts[worker]; // 栈与 arena 都不与其他线程共享
+        for (size_t i = begin; i < end; i++)
+        {
+            c.json = json + s.offsets[i];
+            c.end = json + ends[i];
+            s.rets[i] = lept_parse_tree(c, s.values[i], s.options);
+        }
+    });
+    return n;
+}
+
+size_t lept_batch::lept_get_size() const
+{
+    return state->values.size();
+}
+
+const lept_value &lept_batch::lept_get_value(size_t index) const
+{
+    return state->values[index];
+}
+
+lept_parse_ret lept_batch::lept_get_error(size_t index) const
+{
+    return state->rets[index];
+}
+
+size_t lept_batch::lept_get_offset(size_t index) const
+{
+    return state->offsets[index];
+}
+
+/************************************************************************************************ */
+
+/*
+ * 顶层数组的并行解析
+ * 输入切成若干段，第一遍各段并行统计未转义引号的奇偶，并分别假设段首在字符串外、字符串内，算出括号深度的变化；
+ * 顺序累加得到每段开头的字符串状态与深度后，第二遍各段并行找出深度为 1 的 ',' 与闭合数组的括号，
+ * 它们把数组切成各个元素，最后并行解析各元素，按原顺序组装成数组。
+ * 只有输入合法时切分才一定正确；有元素解析失败或切分不成立时退回顺序解析，结果与错误码都与 lept_parse 相同。
+ */
+
+/** 一段的扫描结果 */
+struct lept_chunk_scan
+{
+    bool quote_odd;           // 未转义的引号个数为奇数
+    int64_t depth[2];         // 假设段首在字符串外、内时，段末相对段首的深度
+    bool in_string;           // 段首是否在字符串内
+    int64_t start_depth;      // 段首的深度
+    std::vector<size_t> seps; // 段中深度为 1 的 ',' 与回到深度 0 的括号
+};
+
+/**
+ * 逐块扫描 [p, end)，p 与 begin 相距 64 字节的整数倍；对每块调用 f(块首, 运算符位图, 字符串区域位图)
+ * in_string 为段首是否在字符串内，返回段末是否在字符串内
+ */
+template <typename F> bool lept_scan_blocks(const char *begin, const char *p, const char *end, bool in_string, F f)
+{
+    lept_index_carry carry = {0, in_string ? ~(uint64_t)0 : 0, 0};
+    for (const char *q = p; q > begin && q[-1] == '\\'; q--) // 段首之前连续奇数个 '\\' 时段首被转义
+        carry.escaped ^= 1;
+    for (; p < end; p += 64)
+    {
+        lept_block_masks m;
+        if (end - p >= 64)
+            lept_classify_block(p, m);
+        else
+        {
+            char tail[64];
+            memset(tail, ' ', sizeof(tail));
+            memcpy(tail, p, end - p);
+            lept_classify_block(tail, m);
+        }
+        uint64_t quote = m.quote & ~lept_find_escaped(m.backslash, carry);
+        uint64_t in = lept_prefix_xor(quote) ^ carry.in_string;
+        carry.in_string = (uint64_t)((int64_t)in >> 63);
+        f(p, m.op, in);
+    }
+    return carry.in_string != 0;
+}
+
+/** 括号对深度的影响 */
+int lept_depth_change(char ch)
+{
+    return ch == '[' || ch == '{' ? 1 : ch == ']' || ch == '}' ? -1 : 0;
+}
+
+/** 切分顶层数组，seps 依次得到开头的 '['、各元素之后的 ',' 与最后的 ']'；不是能切分的数组时返回 false */
+bool lept_split_array(const char *json, size_t len, unsigned threads, std::vector<size_t> &seps)
+{
+    const char *end = json + len;
+    const char *open = json;
+    while (open < end && (*open == ' ' || *open == '\t' || *open == '\n' || *open == '\r'))
+        open++;
+    if (open == end || *open != '[')
+        return false;
+
+    size_t chunk = (len / threads / 4 + 63) & ~(size_t)63;
+    if (chunk < 4096)
+        chunk = 4096;
+    std::vector<lept_chunk_scan> scans((len + chunk - 1) / chunk);
+
+    lept_parallel_for(threads, scans.size(), 1, [&](unsigned, size_t begin, size_t end_chunk) {
+        for (size_t k = begin; k < end_chunk; k++)
+        {
+            lept_chunk_scan &s = scans[k];
+            const char *p = json + k * chunk, *e = k + 1 < scans.size() ? p + chunk : end;
+            s.depth[0] = s.depth[1] = 0;
+            s.quote_odd = lept_scan_blocks(json, p, e, false, [&](const char *block, uint64_t op, uint64_t in) {
+                // 假设段首在字符串外时位于字符串内的运算符，在另一种假设下恰好在字符串外
+                for (; op; op &= op - 1)
+                {
+                    int i = __builtin_ctzll(op);
+                    s.depth[(in >> i) & 1] += lept_depth_change(block[i]);
+                }
+            });
+        }
+    });
+
+    bool in_string = false;
+    int64_t depth = 0;
+    for (lept_chunk_scan &s : scans)
+    {
+        s.in_string = in_string;
+        s.start_depth = depth;
+        depth += s.depth[in_string];
+        in_string ^= s.quote_odd;
+    }
+
+    lept_parallel_for(threads, scans.size(), 1, [&](unsigned, size_t begin, size_t end_chunk) {
+        for (size_t k = begin; k < end_chunk; k++)
+        {
+            lept_chunk_scan &s = scans[k];
+            const char *p = json + k * chunk, *e = k + 1 < scans.size() ? p + chunk : end;
+            int64_t d = s.start_depth;
+            lept_scan_blocks(json, p, e, s.in_string, [&](const char *block, uint64_t op, uint64_t in) {
+                for (op &= ~in; op; op &= op - 1)
+                {
+                    int i = __builtin_ctzll(op);
+                    int change = lept_depth_change(block[i]);
+                    d += change;
+                    if ((change < 0 && d == 0) || (block[i] == ',' && d == 1))
+                        s.seps.push_back(block + i - json);
+                }
+            });
+        }
+    });
+
+    seps.assign(1, open - json);
+    for (lept_chunk_scan &s : scans)
+        for (size_t sep : s.seps)
+        {
+            seps.push_back(sep);
+            if (json[sep] != ',') // 第一个回到深度 0 的括号
+            {
+                const char *p = json + sep + 1;
+                while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+                    p++;
+                return json[sep] == ']' && p == end;
+            }
+        }
+    return false;
+}
+
+/**
+ * 切分 [json, json + len) 并以 threads 个线程解析各元素，都成功时把组装好的数组放入 v 并返回 true；
+ * 第 w 个线程用 workers.contexts[w] 解析，数组本身从 arena 分配，为 NULL 时在堆上。
+ * 不能切分或有元素解析失败时返回 false，交给调用者顺序解析
+ */
+bool lept_parse_split(lept_workers &workers, lept_arena *arena, lept_value &v, const char *json, size_t len,
+                      unsigned threads, const lept_parse_options &options)
+{
+    std::vector<size_t> seps;
+    if (threads == 1 || options.max_depth == 0 || !lept_split_array(json, len, threads, seps))
+        return false;
+
+    size_t n = seps.size() - 1; // 第 i 个元素位于 seps[i] 与 seps[i + 1] 之间
+    std::vector<lept_value> elems(n);
+    std::atomic<bool> failed(false);
+    size_t grain = n / threads / 16 ? n / threads / 16 : 1;
+    lept_parse_options element_options = options;
+    element_options.max_depth--; // 元素位于顶层数组之中
+    lept_parallel_for(threads, n, grain, [&](unsigned worker, size_t begin, size_t end) {
+        lept_context &c = workers.contexts[worker];
+        for (size_t i = begin; i < end && !failed.load(std::memory_order_relaxed); i++)
+        {
+            c.json = json + seps[i] + 1;
+            c.end = json + seps[i + 1];
+            if (lept_parse_tree(c, elems[i], element_options) != LEPT_PARSE_OK)
+                failed = true; // 不再继续，交给顺序解析找出位置最靠前的错误
+        }
+    });
+    if (failed)
+        return false;
+    lept_set_array_raw(v, elems.data(), n, arena);
+    return true;
+}
+
+lept_parse_ret lept_value::lept_parse_parallel(lept_value &v, const char *json, size_t len, unsigned threads,
+                                               const lept_parse_options &options)
+{
+    threads = lept_resolve_threads(threads);
+    lept_workers workers;
+    workers.contexts.resize(threads); // 不设 arena，元素在堆上构造，由 v 持有
+    lept_value a;
+    if (!lept_parse_split(workers, NULL, a, json, len, threads, options))
+        return lept_parse(v, json, len, options);
+    v = std::move(a);
+    return LEPT_PARSE_OK;
+}
+
+lept_parse_ret lept_document::lept_parse_parallel(const char *json, size_t len, unsigned threads)
+{
+    lept_reset();
+    threads = lept_resolve_threads(threads);
+    if (!workers)
+        workers = new lept_workers;
+    workers->lept_reserve(threads); // 各上下文不设符号表，它不能在线程间共享
+    if (lept_parse_split(*workers, &arena, root, json, len, threads, options))
+        return LEPT_PARSE_OK;
+    return lept_parse(json, len); // 重新开始，已在各 arena 中构造的元素随之丢弃
+}
@@ -0,0 +1,389 @@
+#include "leptjson.h"
+#include "leptjson_internal.h"
+#include <cstring>
+#include <string>
+#include <vector>
+
+/*
+ * JSON Pointer 与预先编译的路径
+ * 路径由 '/' 分隔的各段组成，段中的 "~1" 表示 '/'，"~0" 表示 '~'；在数组上，段须是没有前导 0 的十进制下标
+ */
+
+/**
+ * 取出 p 开始（'/' 之后）的一段，k、len 为解码后的内容，含转义时解码到 buf 中
+ * 返回段的末尾（下一个 '/' 或 end），'~' 之后不是 '0' 或 '1' 时返回 NULL
+ */
+const char *lept_pointer_token(const char *p, const char *end, const char *&k, size_t &len, std::string &buf)
+{
+    const char *q = (const char *)memchr(p, '/', end - p);
+    if (!q)
+        q = end;
+    k = p;
+    len = q - p;
+    if (!memchr(p, '~', len))
+        return q;
+
+    buf.clear();
+    for (; p < q; p++)
+    {
+        if (*p != '~')
+            buf += *p;
+        else if (++p < q && (*p == '0' || *p == '1'))
+            buf += *p == '0' ? '~' : '/';
+        else
+            return NULL;
+    }
+    k = buf.data();
+    len = buf.size();
+    return q;
+}
+
+/** 段是否为数组下标 */
+bool lept_pointer_index(const char *k, size_t len, size_t &index)
+{
+    if (len == 0 || len > 19 || (len > 1 && k[0] == '0')) // 19 位以内不会溢出
+        return false;
+    index = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        if (k[i] < '0' || k[i] > '9')
+            return false;
+        index = index * 10 + (k[i] - '0');
+    }
+    return true;
+}
+
+lept_value *lept_value::lept_find_pointer(const char *pointer, size_t len)
+{
+    lept_value *v = this;
+    const char *p = pointer, *end = pointer + len;
+    std::string buf; // 只在段中有转义时使用
+    while (p < end)
+    {
+        const char *k;
+        size_t n, index;
+        if (*p != '/' || !(p = lept_pointer_token(p + 1, end, k, n, buf)))
+            return NULL;
+        if (v->type == LEPT_OBJECT)
+            v = v->lept_find_object_value(k, n);
+        else if (v->type == LEPT_ARRAY && lept_pointer_index(k, n, index) && index < v->size)
+            v = &v->u.a[index];
+        else
+            v = NULL;
+        if (!v)
+            return NULL;
+    }
+    return v;
+}
+
+const lept_value *lept_value::lept_find_pointer(const char *pointer, size_t len) const
+{
+    return const_cast<lept_value *>(this)->lept_find_pointer(pointer, len);
+}
+
+lept_value *lept_value::lept_find_pointer(const char *pointer)
+{
+    return lept_find_pointer(pointer, strlen(pointer));
+}
+
+const lept_value *lept_value::lept_find_pointer(const char *pointer) const
+{
+    return lept_find_pointer(pointer, strlen(pointer));
+}
+
+/************************************************************************************************ */
+
+/** 编译后的一段 */
+struct lept_path_segment
+{
+    std::string key; // 解码后的键
+    size_t index;    // 作为数组下标的值，不是下标时为 SIZE_MAX
+    bool wildcard;   // 是否为 "*"
+};
+
+struct lept_path_state
+{
+    std::vector<lept_path_segment> segments;
+    bool valid; // 编译成功
+};
+
+lept_path::lept_path() : state(new lept_path_state)
+{
+    state->valid = false;
+}
+
+lept_path::~lept_path()
+{
+    delete state;
+}
+
+bool lept_path::lept_compile(const char *pointer, size_t len)
+{
+    lept_path_state &s = *state;
+    s.segments.clear();
+    s.valid = false;
+    const char *p = pointer, *end = pointer + len;
+    std::string buf;
+    while (p < end)
+    {
+        const char *k;
+        size_t n;
+        if (*p != '/' || !(p = lept_pointer_token(p + 1, end, k, n, buf)))
+        {
+            s.segments.clear();
+            return false;
+        }
+        lept_path_segment seg;
+        seg.key.assign(k, n);
+        if (!lept_pointer_index(k, n, seg.index))
+            seg.index = SIZE_MAX;
+        seg.wildcard = n == 1 && *k == '*';
+        s.segments.push_back(std::move(seg));
+    }
+    return s.valid = true;
+}
+
+bool lept_path::lept_compile(const char *pointer)
+{
+    return lept_compile(pointer, strlen(pointer));
+}
+
+/** 在树上求值时的结果 */
+struct lept_path_matches
+{
+    const lept_value **out;
+    size_t capacity;
+    size_t count; // 匹配的总数，可能超过 capacity
+    bool all;     // 为 false 时写满 capacity 个就停止
+};
+
+/** 从第 i 段起在 v 中匹配；不再需要更多结果时返回 false */
+bool lept_path_match(const std::vector<lept_path_segment> &segments, size_t i, const lept_value &v,
+                     lept_path_matches &m)
+{
+    if (i == segments.size())
+    {
+        if (m.count < m.capacity)
+            m.out[m.count] = &v;
+        m.count++;
+        return m.all || m.count < m.capacity;
+    }
+
+    const lept_path_segment &s = segments[i];
+    if (v.type == LEPT_ARRAY)
+    {
+        if (!s.wildcard)
+            return s.index < v.size ? lept_path_match(segments, i + 1, v.u.a[s.index], m) : true;
+        for (uint32_t j = 0; j < v.size; j++)
+            if (!lept_path_match(segments, i + 1, v.u.a[j], m))
+                return false;
+    }
+    else if (v.type == LEPT_OBJECT)
+    {
+        if (!s.wildcard)
+        {
+            const lept_value *e = v.lept_find_object_value(s.key.data(), s.key.size());
+            return e ? lept_path_match(segments, i + 1, *e, m) : true;
+        }
+        for (uint32_t j = 0; j < v.size; j++)
+            if (!lept_path_match(segments, i + 1, v.u.o[j].v, m))
+                return false;
+    }
+    return true;
+}
+
+const lept_value *lept_path::lept_find(const lept_value &v) const
+{
+    const lept_value *e = NULL;
+    lept_path_matches m = {&e, 1, 0, false};
+    if (state->valid)
+        lept_path_match(state->segments, 0, v, m);
+    return e;
+}
+
+size_t lept_path::lept_find_all(const lept_value &v, const lept_value **out, size_t capacity) const
+{
+    lept_path_matches m = {out, capacity, 0, true};
+    if (state->valid)
+        lept_path_match(state->segments, 0, v, m);
+    return m.count;
+}
+
+/** 在文本上求值时的状态 */
+struct lept_path_scan
+{
+    const std::vector<lept_path_segment> &segments;
+    size_t first_wildcard; // 第一个通配段的下标，没有时为 SIZE_MAX
+    const char *end;
+    lept_lazy_value *out;
+    size_t capacity;
+    size_t count;
+    bool all;
+    bool stop; // 不会再有新的结果，扫描提前结束
+    lept_parse_ret ret;
+    lept_reader r; // 只在键含转义时用来解码
+};
+
+/**
+ * 第 i 段处的值已经处理完：外层没有通配段时它是唯一可能匹配的位置，扫描就此结束；
+ * 否则跳过值的其余部分，返回值之后的位置
+ */
+const char *lept_path_finish(lept_path_scan &c, size_t i, const char *p)
+{
+    if (c.first_wildcard >= i)
+    {
+        c.stop = true;
+        return NULL;
+    }
+    return p ? lept_skip_value(p, c.end, c.ret) : NULL;
+}
+
+/**
+ * 从第 i 段起在 p 处的值中匹配，返回值之后的位置
+ * 出错（c.ret 不为 LEPT_PARSE_OK）或扫描提前结束（c.stop）时返回 NULL
+ */
+const char *lept_path_match_raw(lept_path_scan &c, size_t i, const char *p)
+{
+    const char *end = c.end;
+    if (p == end)
+    {
+        c.ret = LEPT_PARSE_EXPECT_VALUE;
+        return NULL;
+    }
+    if (i == c.segments.size())
+    {
+        if (c.count < c.capacity)
+            c.out[c.count] = lept_lazy_value::lept_parse(p, end - p);
+        c.count++;
+        if (!c.all && c.count >= c.capacity) // 已经有了所需的全部结果
+        {
+            c.stop = true;
+            return NULL;
+        }
+        return lept_path_finish(c, i, p);
+    }
+
+    const lept_path_segment &s = c.segments[i];
+    if (*p == '[' && (s.wildcard || s.index != SIZE_MAX))
+    {
+        p = lept_skip_whitespace(p + 1, end);
+        if (p < end && *p == ']')
+            return p + 1;
+        for (size_t n = 0;; n++)
+        {
+            if (s.wildcard || n == s.index)
+            {
+                if (!(p = lept_path_match_raw(c, i + 1, p)))
+                    return NULL;
+                if (!s.wildcard && c.first_wildcard >= i) // 之后的元素只需跳过；外层没有通配段时不必找到数组的末尾
+                    return lept_path_finish(c, i, NULL);
+            }
+            else if (!(p = lept_skip_value(p, end, c.ret)))
+                return NULL;
+            p = lept_skip_whitespace(p, end);
+            if (p < end && *p == ',')
+                p = lept_skip_whitespace(p + 1, end);
+            else if (p < end && *p == ']')
+                return p + 1;
+            else
+            {
+                c.ret = LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+                return NULL;
+            }
+        }
+    }
+    if (*p != '{') // 标量，或不能按键下降的数组
+        return lept_path_finish(c, i, p);
+
+    p = lept_skip_whitespace(p + 1, end);
+    if (p < end && *p == '}')
+        return p + 1;
+    bool found = false; // 重复的键取第一个，之后的成员只需跳过
+    while (true)
+    {
+        if (p == end || *p != '"')
+        {
+            c.ret = LEPT_PARSE_MISS_KEY;
+            return NULL;
+        }
+        bool match = s.wildcard;
+        if (!match && !found)
+        {
+            const char *q = lept_scan_string(p + 1, end); // 第一个 '"'、'\\' 或控制字符
+            c.r.json = p;
+            c.r.end = end;
+            match = q < end && lept_lazy_key_equal(c.r, q, s.key.data(), s.key.size());
+        }
+        if (!(p = lept_skip_string(p + 1, end)))
+        {
+            c.ret = LEPT_PARSE_MISS_QUOTATION_MARK;
+            return NULL;
+        }
+
+        p = lept_skip_whitespace(p, end);
+        if (p == end || *p != ':')
+        {
+            c.ret = LEPT_PARSE_MISS_COLON;
+            return NULL;
+        }
+        p = lept_skip_whitespace(p + 1, end);
+        if (match)
+        {
+            if (!(p = lept_path_match_raw(c, i + 1, p)))
+                return NULL;
+            if (!s.wildcard)
+            { // 外层没有通配段时不必找到对象的末尾
+                found = true;
+                if (c.first_wildcard >= i)
+                    return lept_path_finish(c, i, NULL);
+            }
+        }
+        else if (!(p = lept_skip_value(p, end, c.ret)))
+            return NULL;
+        p = lept_skip_whitespace(p, end);
+        if (p < end && *p == ',')
+            p = lept_skip_whitespace(p + 1, end);
+        else if (p < end && *p == '}')
+            return p + 1;
+        else
+        {
+            c.ret = LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+            return NULL;
+        }
+    }
+}
+
+/** 在 [json, json + len) 上求值 */
+lept_parse_ret lept_path_find_raw(const lept_path_state &s, const char *json, size_t len, lept_lazy_value *out,
+                                  size_t capacity, bool all, size_t &count)
+{
+    size_t first_wildcard = 0;
+    while (first_wildcard < s.segments.size() && !s.segments[first_wildcard].wildcard)
+        first_wildcard++;
+    if (first_wildcard == s.segments.size())
+        first_wildcard = SIZE_MAX;
+    lept_path_scan c = {s.segments, first_wildcard, json + len, out, capacity, 0, all, false, LEPT_PARSE_OK, lept_reader()};
+    if (s.valid)
+        lept_path_match_raw(c, 0, lept_skip_whitespace(json, c.end));
+    count = c.count;
+    return c.ret;
+}
+
+lept_lazy_value lept_path::lept_find(const char *json, size_t len) const
+{
+    lept_lazy_value v;
+    size_t count;
+    lept_parse_ret ret = lept_path_find_raw(*state, json, len, &v, 1, false, count);
+    if (ret != LEPT_PARSE_OK)
+    {
+        v = lept_lazy_value();
+        v.ret = ret;
+    }
+    return v;
+}
+
+lept_parse_ret lept_path::lept_find_all(const char *json, size_t len, lept_lazy_value *out, size_t capacity,
+                                        size_t &count) const
+{
+    return lept_path_find_raw(*state, json, len, out, capacity, true, count);
+}
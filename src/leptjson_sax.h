@@ -0,0 +1,203 @@
+#pragma once
+
+#include "leptjson.h"
+#include <vector>
+
+/*
+ * 事件式解析
+ * 按文本顺序调用处理器的成员函数，不构造 lept_value 树。处理器作为模板参数传入，调用可以完全内联。
+ * 处理器需要提供：
+ *     void lept_null();
+ *     void lept_boolean(bool b);
+ *     void lept_number(double n);
+ *     void lept_int64(int64_t i);   // 没有小数与指数部分的整数
+ *     void lept_uint64(uint64_t u); // 超过 INT64_MAX 的整数
+ *     void lept_string(const char *s, size_t len);
+ *     void lept_start_array();
+ *     void lept_end_array(size_t n); // n 为元素个数
+ *     void lept_start_object();
+ *     void lept_key(const char *s, size_t len);
+ *     void lept_end_object(size_t n); // n 为成员个数
+ * 字符串与键的内容只在回调期间有效；出错时已经发出的事件不会撤回
+ */
+
+/** 尚未闭合的数组或对象 */
+struct lept_reader_frame
+{
+    size_t n;    // 已有的元素或成员个数
+    bool object; // 是否为对象
+};
+
+/** 事件式解析的输入状态 */
+struct lept_reader
+{
+    const char *json;                                  // 当前解析json所指向的部分
+    const char *end;                                   // json文本的末尾，不要求以 '\0' 结尾
+    std::vector<char> chars;                           // 解码含转义的字符串时的临时缓冲，整个解析过程复用
+    bool insitu = false;                               // 原地解析：字符串就地解码并以 '\0' 结尾，此时输入须可写
+    size_t max_depth = lept_parse_options().max_depth; // 最大嵌套深度
+    std::vector<lept_reader_frame> frames;             // 代替递归的容器栈，整个解析过程复用
+};
+
+/* 记号解析，成功时 r.json 移到记号之后 */
+char lept_peek(const lept_reader &r, const char *p);              // p 处的字符，到达末尾时为 '\0'
+void lept_parse_whitespace(lept_reader &r);                       // 吃掉空白符
+lept_parse_ret lept_parse_literal(lept_reader &r, lept_value &v); // null / false / true
+lept_parse_ret lept_parse_number(lept_reader &r, lept_value &v);
+lept_parse_ret lept_parse_string_raw(lept_reader &r, const char *&s, size_t &len); // s 指向输入或 r.chars
+
+/** 解析数字或字面量并发出对应的事件 */
+template <typename H> lept_parse_ret lept_parse_scalar(lept_reader &r, H &h)
+{
+    lept_value v; // 字面量与数字先解析为标量，不会分配内存
+    char ch = *r.json;
+    lept_parse_ret ret = ch == 'n' || ch == 'f' || ch == 't' ? lept_parse_literal(r, v) : lept_parse_number(r, v);
+    if (ret != LEPT_PARSE_OK)
+        return ret;
+    switch (v.type)
+    {
+    case LEPT_NULL:
+        h.lept_null();
+        break;
+    case LEPT_FALSE:
+    case LEPT_TRUE:
+        h.lept_boolean(v.type == LEPT_TRUE);
+        break;
+    default:
+        if (v.flags & LEPT_FLAG_INT64)
+            h.lept_int64(v.u.i64);
+        else if (v.flags & LEPT_FLAG_UINT64)
+            h.lept_uint64(v.u.u64);
+        else
+            h.lept_number(v.u.n);
+    }
+    return LEPT_PARSE_OK;
+}
+
+/*
+ * value = null / false / true / number / string / array / object
+ * array = %x5B ws [ value *( ws %x2C ws value ) ] ws %x5D
+ * object = %x7B ws [ member *( ws %x2C ws member ) ] ws %x7D
+ * member = string ws %x3A ws value
+ */
+/** 解析 r.json 处的一个值；容器用 r.frames 代替递归，每层只占一个 lept_reader_frame */
+template <typename H> lept_parse_ret lept_parse_value(lept_reader &r, H &h)
+{
+    std::vector<lept_reader_frame> &frames = r.frames;
+    frames.clear();
+    lept_parse_ret ret;
+    const char *s;
+    size_t len;
+
+value: // r.json 处应当是一个值
+    if (r.json == r.end)
+        return LEPT_PARSE_EXPECT_VALUE;
+    switch (*r.json)
+    {
+    case '"':
+        if ((ret = lept_parse_string_raw(r, s, len)) != LEPT_PARSE_OK)
+            return ret;
+        h.lept_string(s, len);
+        goto next;
+    case '[':
+    case '{': {
+        if (frames.size() >= r.max_depth)
+            return LEPT_PARSE_TOO_DEEP;
+        bool object = *r.json++ == '{';
+        if (object)
+            h.lept_start_object();
+        else
+            h.lept_start_array();
+        lept_parse_whitespace(r);
+        if (lept_peek(r, r.json) == (object ? '}' : ']'))
+        {
+            r.json++;
+            if (object)
+                h.lept_end_object(0);
+            else
+                h.lept_end_array(0);
+            goto next;
+        }
+        frames.push_back({1, object});
+        if (object)
+            goto key;
+        goto value;
+    }
+    default:
+        if ((ret = lept_parse_scalar(r, h)) != LEPT_PARSE_OK)
+            return ret;
+        goto next;
+    }
+
+key: // r.json 处应当是对象的键
+    if (lept_peek(r, r.json) != '"')
+        return LEPT_PARSE_MISS_KEY;
+    if ((ret = lept_parse_string_raw(r, s, len)) != LEPT_PARSE_OK)
+        return ret;
+    h.lept_key(s, len);
+    lept_parse_whitespace(r);
+    if (lept_peek(r, r.json) != ':')
+        return LEPT_PARSE_MISS_COLON;
+    r.json++;
+    lept_parse_whitespace(r);
+    goto value;
+
+next: // 一个值结束，接下来是所在容器的 ',' 或闭合的括号
+    if (frames.empty())
+        return LEPT_PARSE_OK;
+    lept_parse_whitespace(r);
+    if (lept_peek(r, r.json) == ',')
+    {
+        r.json++;
+        lept_parse_whitespace(r);
+        frames.back().n++;
+        if (frames.back().object)
+            goto key;
+        goto value;
+    }
+    if (lept_peek(r, r.json) == (frames.back().object ? '}' : ']'))
+    {
+        r.json++;
+        lept_reader_frame f = frames.back();
+        frames.pop_back();
+        if (f.object)
+            h.lept_end_object(f.n);
+        else
+            h.lept_end_array(f.n);
+        goto next;
+    }
+    return frames.back().object ? LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET : LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+}
+
+/** 解析 [r.json, r.end) 中完整的json文本 */
+template <typename H> lept_parse_ret lept_parse_events(lept_reader &r, H &h)
+{
+    lept_parse_whitespace(r);
+    lept_parse_ret ret = lept_parse_value(r, h);
+    if (ret == LEPT_PARSE_OK)
+    {
+        lept_parse_whitespace(r);
+        if (r.json != r.end)
+            ret = LEPT_PARSE_ROOT_NOT_SINGULAR;
+    }
+    return ret;
+}
+
+/** 解析 [json, json + len) 中的json文本，依次向 h 发出事件 */
+template <typename H> lept_parse_ret lept_parse_events(const char *json, size_t len, H &h)
+{
+    lept_reader r;
+    r.json = json;
+    r.end = json + len;
+    return lept_parse_events(r, h);
+}
+
+/** 原地解析 [json, json + len)：字符串在输入中就地解码，事件中的字符串以 '\0' 结尾并在输入存续期间一直有效 */
+template <typename H> lept_parse_ret lept_parse_events_insitu(char *json, size_t len, H &h)
+{
+    lept_reader r;
+    r.json = json;
+    r.end = json + len;
+    r.insitu = true;
+    return lept_parse_events(r, h);
+}
@@ -0,0 +1,330 @@
+#include "leptjson.h"
+#include "leptjson_internal.h"
+#include <cassert>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+/** 增量解析时下一个记号的预期 */
+enum lept_stream_expect
+{
+    LEPT_STREAM_ROOT,         // 根值
+    LEPT_STREAM_ROOT_END,     // 根值之后只能有空白
+    LEPT_STREAM_ARRAY_FIRST,  // '[' 之后：值或 ']'
+    LEPT_STREAM_ARRAY_VALUE,  // ',' 之后：值
+    LEPT_STREAM_ARRAY_NEXT,   // 值之后：',' 或 ']'
+    LEPT_STREAM_OBJECT_FIRST, // '{' 之后：键或 '}'
+    LEPT_STREAM_OBJECT_KEY,   // ',' 之后：键
+    LEPT_STREAM_OBJECT_COLON, // 键之后：':'
+    LEPT_STREAM_OBJECT_VALUE, // ':' 之后：值
+    LEPT_STREAM_OBJECT_NEXT,  // 值之后：',' 或 '}'
+};
+
+/** 尚未闭合的数组或对象 */
+struct lept_stream_frame
+{
+    lept_type type; // LEPT_ARRAY 或 LEPT_OBJECT
+    size_t base;    // 本层元素或成员在栈中的起始位置
+};
+
+struct lept_stream_state
+{
+    lept_context c;                         // 复用一次性解析的栈与记号解析函数
+    std::vector<lept_stream_frame> frames;  // 代替递归的容器栈
+    lept_stream_expect expect;              // 下一个记号的预期
+    std::vector<char> carry;                // 被分块截断的记号，为空表示没有
+    bool escaped;                           // carry 中的字符串以未配对的 '\\' 结尾
+    lept_parse_ret ret;                     // 已确定的结果，出错后不再变化
+    lept_value root;
+};
+
+/** 可能出现在数字或字面量中的字符 */
+bool lept_is_token_char(char ch)
+{
+    return (ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || ch == '+' ||
+           ch == '-' || ch == '.';
+}
+
+/** 数字或字面量在 [p, end) 中的结尾，到达 end 时返回 NULL */
+const char *lept_find_token_end(const char *p, const char *end)
+{
+    while (p < end && lept_is_token_char(*p))
+        p++;
+    return p < end ? p : NULL;
+}
+
+/**
+ * 从 p（开头的 '"' 之后）开始寻找字符串记号的结尾，即闭合的 '"' 或非法控制字符之后，到达 end 时返回 NULL
+ * escaped 为 true 时 p 处的字符已被前一块末尾的 '\\' 转义，返回 NULL 时更新为本块末尾的状态
+ */
+const char *lept_find_string_end(const char *p, const char *end, bool &escaped)
+{
+    if (escaped)
+    {
+        if (p == end)
+            return NULL;
+        p++;
+        escaped = false;
+    }
+    while (true)
+    {
+        p = lept_scan_string(p, end);
+        if (p == end)
+            return NULL;
+        if (*p != '\\')
+            return p + 1; // '"' 或控制字符，控制字符的错误交给 lept_parse_string 报告
+        if (++p == end)
+        {
+            escaped = true;
+            return NULL;
+        }
+        p++;
+    }
+}
+
+/** 将解析出的值交给所在的容器 */
+void lept_stream_put(lept_stream_state &s, lept_value &v)
+{
+    if (s.frames.empty())
+    {
+        s.root = std::move(v);
+        s.expect = LEPT_STREAM_ROOT_END;
+    }
+    else if (s.frames.back().type == LEPT_ARRAY)
+    {
+        s.c.values.push_back(std::move(v));
+        s.expect = LEPT_STREAM_ARRAY_NEXT;
+    }
+    else
+    {
+        s.c.members.back().v = std::move(v);
+        s.expect = LEPT_STREAM_OBJECT_NEXT;
+    }
+}
+
+/** 闭合最内层的容器 */
+void lept_stream_close(lept_stream_state &s)
+{
+    lept_stream_frame f = s.frames.back();
+    s.frames.pop_back();
+    lept_value v;
+    if (f.type == LEPT_ARRAY)
+    {
+        lept_set_array_raw(v, s.c.values.data() + f.base, s.c.values.size() - f.base);
+        s.c.values.erase(s.c.values.begin() + f.base, s.c.values.end());
+    }
+    else
+    {
+        lept_set_object_raw(v, s.c.members.data() + f.base, s.c.members.size() - f.base, NULL, s.c.object_index_min);
+        s.c.members.erase(s.c.members.begin() + f.base, s.c.members.end());
+    }
+    lept_stream_put(s, v);
+}
+
+/** 值之后出现了不能接续的字符 */
+lept_parse_ret lept_stream_unexpected(lept_stream_expect expect)
+{
+    switch (expect)
+    {
+    case LEPT_STREAM_ARRAY_NEXT:
+        return LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET;
+    case LEPT_STREAM_OBJECT_NEXT:
+        return LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET;
+    case LEPT_STREAM_OBJECT_COLON:
+        return LEPT_PARSE_MISS_COLON;
+    default:
+        return LEPT_PARSE_ROOT_NOT_SINGULAR;
+    }
+}
+
+/** 解析 [p, end) 中以 p 开头的完整记号，作为键或值交给所在的容器，成功时 next 指向记号之后 */
+lept_parse_ret lept_stream_token(lept_stream_state &s, const char *p, const char *end, const char *&next)
+{
+    lept_context &c = s.c;
+    c.json = p;
+    c.end = end;
+    lept_parse_ret ret;
+    if (s.expect == LEPT_STREAM_OBJECT_FIRST || s.expect == LEPT_STREAM_OBJECT_KEY)
+    {
+        const char *k;
+        size_t len;
+        if ((ret = lept_parse_string_raw(c, k, len)) != LEPT_PARSE_OK)
+            return ret;
+        c.members.emplace_back();
+        lept_set_string_raw(c.members.back().k, k, len);
+        s.expect = LEPT_STREAM_OBJECT_COLON;
+    }
+    else
+    { // 这里只会是标量，由树的处理器压入栈顶后取出
+        lept_value_handler h = {c};
+        if ((ret = lept_parse_value(c, h)) != LEPT_PARSE_OK)
+            return ret;
+        lept_value v(std::move(c.values.back()));
+        c.values.pop_back();
+        lept_stream_put(s, v);
+    }
+    next = c.json;
+    return LEPT_PARSE_OK;
+}
+
+/** 解析一块输入，final 表示输入到此结束 */
+lept_parse_ret lept_stream_run(lept_stream_state &s, const char *p, const char *end, bool final)
+{
+    lept_parse_ret ret;
+    if (!s.carry.empty())
+    { // 先补全上一块截断的记号，只复制记号剩余的部分
+        const char *q = s.carry[0] == '"' ? lept_find_string_end(p, end, s.escaped) : lept_find_token_end(p, end);
+        if (!q && !final)
+        {
+            s.carry.insert(s.carry.end(), p, end);
+            return LEPT_PARSE_INCOMPLETE;
+        }
+        if (!q)
+            q = end;
+        s.carry.insert(s.carry.end(), p, q);
+
+        const char *t = s.carry.data(), *t_end = t + s.carry.size(), *next;
+        if ((ret = lept_stream_token(s, t, t_end, next)) != LEPT_PARSE_OK)
+            return ret;
+        if (next != t_end) // 数字或字面量之后紧跟着其他字母数字
+            return lept_stream_unexpected(s.expect);
+        s.carry.clear();
+        p = q;
+    }
+
+    while (true)
+    {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+            p++;
+        if (p == end)
+        {
+            if (s.expect == LEPT_STREAM_ROOT_END)
+                return LEPT_PARSE_OK;
+            if (!final)
+                return LEPT_PARSE_INCOMPLETE;
+        }
+        char ch = p < end ? *p : '\0';
+
+        switch (s.expect)
+        {
+        case LEPT_STREAM_ROOT_END:
+            return LEPT_PARSE_ROOT_NOT_SINGULAR;
+        case LEPT_STREAM_ARRAY_NEXT:
+        case LEPT_STREAM_OBJECT_NEXT:
+            if (ch == ',')
+            {
+                s.expect = s.expect == LEPT_STREAM_ARRAY_NEXT ? LEPT_STREAM_ARRAY_VALUE : LEPT_STREAM_OBJECT_KEY;
+                p++;
+                continue;
+            }
+            if (ch == (s.expect == LEPT_STREAM_ARRAY_NEXT ? ']' : '}'))
+            {
+                lept_stream_close(s);
+                p++;
+                continue;
+            }
+            return lept_stream_unexpected(s.expect);
+        case LEPT_STREAM_OBJECT_COLON:
+            if (ch != ':')
+                return LEPT_PARSE_MISS_COLON;
+            s.expect = LEPT_STREAM_OBJECT_VALUE;
+            p++;
+            continue;
+        case LEPT_STREAM_OBJECT_FIRST:
+            if (ch == '}')
+            {
+                lept_stream_close(s);
+                p++;
+                continue;
+            }
+            /* fall through */
+        case LEPT_STREAM_OBJECT_KEY:
+            if (ch != '"')
+                return LEPT_PARSE_MISS_KEY;
+            break;
+        case LEPT_STREAM_ARRAY_FIRST:
+            if (ch == ']')
+            {
+                lept_stream_close(s);
+                p++;
+                continue;
+            }
+            /* fall through */
+        default: // 值
+            if (p == end)
+                return LEPT_PARSE_EXPECT_VALUE;
+            if (ch == '[' || ch == '{')
+            {
+                if (s.frames.size() >= s.c.max_depth)
+                    return LEPT_PARSE_TOO_DEEP;
+                lept_stream_frame f;
+                f.type = ch == '[' ? LEPT_ARRAY : LEPT_OBJECT;
+                f.base = ch == '[' ? s.c.values.size() : s.c.members.size();
+                s.frames.push_back(f);
+                s.expect = ch == '[' ? LEPT_STREAM_ARRAY_FIRST : LEPT_STREAM_OBJECT_FIRST;
+                p++;
+                continue;
+            }
+            if (ch != '"' && !lept_is_token_char(ch))
+                return LEPT_PARSE_INVALID_VALUE;
+        }
+
+        /* 字符串、数字或字面量：完整时直接从输入解析，否则暂存等待下一块 */
+        bool escaped = false;
+        const char *q = ch == '"' ? lept_find_string_end(p + 1, end, escaped) : lept_find_token_end(p, end);
+        if (!q && !final)
+        {
+            s.carry.assign(p, end);
+            s.escaped = escaped;
+            return LEPT_PARSE_INCOMPLETE;
+        }
+        if ((ret = lept_stream_token(s, p, end, p)) != LEPT_PARSE_OK)
+            return ret;
+    }
+}
+
+/** 丢弃解析中间状态，准备解析下一个文档 */
+void lept_stream_reset(lept_stream_state &s)
+{
+    s.c.values.clear();
+    s.c.members.clear();
+    s.frames.clear();
+    s.expect = LEPT_STREAM_ROOT;
+    s.carry.clear();
+    s.escaped = false;
+    s.ret = LEPT_PARSE_INCOMPLETE;
+    s.root.lept_free();
+}
+
+lept_stream::lept_stream(const lept_parse_options &options) : state(new lept_stream_state)
+{
+    state->c.arena = NULL;
+    state->c.max_depth = options.max_depth;
+    state->c.object_index_min = options.object_index_min;
+    lept_stream_reset(*state);
+}
+
+lept_stream::~lept_stream()
+{
+    delete state;
+}
+
+lept_parse_ret lept_stream::lept_feed(const char *data, size_t len)
+{
+    lept_stream_state &s = *state;
+    if (s.ret == LEPT_PARSE_INCOMPLETE || s.ret == LEPT_PARSE_OK)
+        s.ret = lept_stream_run(s, data, data + len, false);
+    return s.ret;
+}
+
+lept_parse_ret lept_stream::lept_finish(lept_value &v)
+{
+    lept_stream_state &s = *state;
+    if (s.ret == LEPT_PARSE_INCOMPLETE || s.ret == LEPT_PARSE_OK)
+        s.ret = lept_stream_run(s, NULL, NULL, true);
+    lept_parse_ret ret = s.ret;
+    if (ret == LEPT_PARSE_OK)
+        v = std::move(s.root);
+    lept_stream_reset(s);
+    return ret;
+}
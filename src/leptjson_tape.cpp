@@ -0,0 +1,551 @@
+#include "leptjson.h"
+#include "leptjson_internal.h"
+#include <cassert>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+/*
+ * 二进制 tape
+ * 8 字节的文件头（魔数与版本号）之后是根值，各值的格式见 lept_tape_value。
+ * 数组与对象记录了内容的长度，访问时可以直接跳过；长度与个数都在写入时确定，读取时只做范围检查
+ */
+
+/** 值的标签 */
+enum lept_tape_tag
+{
+    LEPT_TAPE_NULL,
+    LEPT_TAPE_FALSE,
+    LEPT_TAPE_TRUE,
+    LEPT_TAPE_DOUBLE, // 8 字节的 double
+    LEPT_TAPE_INT64,  // 8 字节的 int64_t
+    LEPT_TAPE_UINT64, // 8 字节的 uint64_t
+    LEPT_TAPE_STRING, // 4 字节长度、内容与 '\0'
+    LEPT_TAPE_ARRAY,  // 4 字节元素个数、8 字节内容长度，之后是各元素
+    LEPT_TAPE_OBJECT, // 4 字节成员个数、8 字节内容长度，之后是各成员的键与值
+};
+
+const uint32_t lept_tape_magic = 0x5450454c;  // 小端机器上为 "LEPT"
+const uint32_t lept_tape_version = 1;
+const size_t lept_tape_header_size = 8;     // 文件头
+const size_t lept_tape_container_size = 13; // 数组与对象的标签、个数与内容长度
+
+/** 读写 tape 中未对齐的整数与浮点数 */
+template <typename T> T lept_tape_load(const char *p)
+{
+    T x;
+    memcpy(&x, p, sizeof(x));
+    return x;
+}
+
+template <typename T> void lept_tape_store(char *p, T x)
+{
+    memcpy(p, &x, sizeof(x));
+}
+
+/** 写入字符串或键（不含标签） */
+void lept_tape_put_string(lept_buffer &b, const char *s, uint32_t len)
+{
+    char *p = b.lept_push(4 + len + 1);
+    lept_tape_store(p, len);
+    memcpy(p + 4, s, len);
+    p[4 + len] = '\0';
+}
+
+/** 写入数组与对象之外的值 */
+void lept_tape_put_scalar(lept_buffer &b, const lept_value &v)
+{
+    switch (v.type)
+    {
+    case LEPT_NULL:
+        *b.lept_push(1) = LEPT_TAPE_NULL;
+        break;
+    case LEPT_FALSE:
+        *b.lept_push(1) = LEPT_TAPE_FALSE;
+        break;
+    case LEPT_TRUE:
+        *b.lept_push(1) = LEPT_TAPE_TRUE;
+        break;
+    case LEPT_NUMBER: {
+        char *p = b.lept_push(9);
+        if (v.flags & LEPT_FLAG_INT64)
+        {
+            *p = LEPT_TAPE_INT64;
+            lept_tape_store(p + 1, v.u.i64);
+        }
+        else if (v.flags & LEPT_FLAG_UINT64)
+        {
+            *p = LEPT_TAPE_UINT64;
+            lept_tape_store(p + 1, v.u.u64);
+        }
+        else
+        {
+            *p = LEPT_TAPE_DOUBLE;
+            lept_tape_store(p + 1, v.u.n);
+        }
+        break;
+    }
+    case LEPT_STRING:
+        *b.lept_push(1) = LEPT_TAPE_STRING;
+        lept_tape_put_string(b, v.u.s, v.size);
+        break;
+    default:
+        break;
+    }
+}
+
+/** 编码时尚未写完的数组或对象 */
+struct lept_tape_encode_frame
+{
+    const lept_value *v;
+    uint32_t next; // 下一个要写的元素或成员
+    size_t start;  // 容器在 b 中的起始位置，写完后回填内容长度
+};
+
+/** 写入数组或对象的标签与个数，内容长度留待写完后回填 */
+void lept_tape_open(lept_buffer &b, const lept_value &v, lept_walk_stack<lept_tape_encode_frame> &stack)
+{
+    size_t start = b.lept_get_size();
+    char *p = b.lept_push(lept_tape_container_size);
+    *p = v.type == LEPT_ARRAY ? LEPT_TAPE_ARRAY : LEPT_TAPE_OBJECT;
+    lept_tape_store(p + 1, v.size);
+    stack.push_back(lept_tape_encode_frame{&v, 0, start});
+}
+
+/** 用显式的栈代替递归，栈的用量与嵌套深度无关 */
+void lept_tape_encode(lept_buffer &b, const lept_value &root)
+{
+    if (root.type != LEPT_ARRAY && root.type != LEPT_OBJECT)
+    {
+        lept_tape_put_scalar(b, root);
+        return;
+    }
+    lept_walk_stack<lept_tape_encode_frame> stack;
+    lept_tape_open(b, root, stack);
+    while (!stack.empty())
+    {
+        const lept_value *c = stack.back().v, *e = NULL;
+        uint32_t i = stack.back().next;
+        for (; i < c->size; i++) // 逐个写出 c 的元素或成员，遇到数组或对象时转而写它
+        {
+            if (c->type == LEPT_ARRAY)
+                e = &c->u.a[i];
+            else
+            {
+                lept_tape_put_string(b, c->u.o[i].k.u.s, c->u.o[i].k.size);
+                e = &c->u.o[i].v;
+            }
+            if (e->type == LEPT_ARRAY || e->type == LEPT_OBJECT)
+                break;
+            lept_tape_put_scalar(b, *e);
+        }
+        if (i < c->size)
+        {
+            stack.back().next = i + 1;
+            lept_tape_open(b, *e, stack);
+            continue;
+        }
+        size_t start = stack.back().start;
+        stack.pop_back();
+        uint64_t n = b.lept_get_size() - start - lept_tape_container_size; // 内容写完才知道长度，回填
+        lept_tape_store(const_cast<char *>(b.lept_get_data()) + start + 5, n); // 已经写入过，内容在 b 自己的内存中
+    }
+}
+
+void lept_value::lept_encode(const lept_value &v, lept_buffer &b)
+{
+    char *p = b.lept_push(lept_tape_header_size);
+    lept_tape_store(p, lept_tape_magic);
+    lept_tape_store(p + 4, lept_tape_version);
+    lept_tape_encode(b, v);
+}
+
+/** p 处的键（或去掉标签的字符串）在 [p, end) 中所占的字节数，不完整或没有以 '\0' 结尾时为 0 */
+size_t lept_tape_string_extent(const char *p, const char *end)
+{
+    size_t left = end - p;
+    if (left < 5)
+        return 0;
+    uint32_t n = lept_tape_load<uint32_t>(p);
+    return n <= left - 5 && p[4 + n] == '\0' ? 5 + n : 0;
+}
+
+/** p 处的值在 [p, end) 中所占的字节数，不完整或标签未知时为 0 */
+size_t lept_tape_extent(const char *p, const char *end)
+{
+    size_t left = end - p;
+    if (left == 0)
+        return 0;
+    switch (*p)
+    {
+    case LEPT_TAPE_NULL:
+    case LEPT_TAPE_FALSE:
+    case LEPT_TAPE_TRUE:
+        return 1;
+    case LEPT_TAPE_DOUBLE:
+    case LEPT_TAPE_INT64:
+    case LEPT_TAPE_UINT64:
+        return left >= 9 ? 9 : 0;
+    case LEPT_TAPE_STRING: {
+        size_t n = lept_tape_string_extent(p + 1, end);
+        return n ? 1 + n : 0;
+    }
+    case LEPT_TAPE_ARRAY:
+    case LEPT_TAPE_OBJECT: {
+        if (left < lept_tape_container_size)
+            return 0;
+        uint64_t n = lept_tape_load<uint64_t>(p + 5);
+        return n <= left - lept_tape_container_size ? lept_tape_container_size + n : 0;
+    }
+    default:
+        return 0;
+    }
+}
+
+/** 还原中尚未闭合的数组或对象 */
+struct lept_tape_frame
+{
+    const char *end; // 外层内容的末尾
+    uint32_t size;   // 元素或成员个数
+    uint32_t left;   // 尚未还原的元素或成员个数
+    bool object;
+};
+
+/**
+ * 按文本顺序为 [p, end) 中的一个值发出事件，处理器与事件式解析的相同；不递归。
+ * 值须恰好占满 [p, end)，各容器的个数须与内容长度相符，否则返回 LEPT_PARSE_INVALID_VALUE
+ */
+template <typename H> lept_parse_ret lept_tape_decode(const char *p, const char *end, size_t max_depth, H &h)
+{
+    std::vector<lept_tape_frame> frames;
+    while (true)
+    {
+        size_t n = lept_tape_extent(p, end);
+        if (n == 0)
+            return LEPT_PARSE_INVALID_VALUE;
+        switch (*p)
+        {
+        case LEPT_TAPE_NULL:
+            h.lept_null();
+            break;
+        case LEPT_TAPE_FALSE:
+        case LEPT_TAPE_TRUE:
+            h.lept_boolean(*p == LEPT_TAPE_TRUE);
+            break;
+        case LEPT_TAPE_DOUBLE:
+            h.lept_number(lept_tape_load<double>(p + 1));
+            break;
+        case LEPT_TAPE_INT64:
+            h.lept_int64(lept_tape_load<int64_t>(p + 1));
+            break;
+        case LEPT_TAPE_UINT64:
+            h.lept_uint64(lept_tape_load<uint64_t>(p + 1));
+            break;
+        case LEPT_TAPE_STRING:
+            h.lept_string(p + 5, lept_tape_load<uint32_t>(p + 1));
+            break;
+        default: { // 数组或对象，之后逐个还原其内容
+            if (frames.size() >= max_depth)
+                return LEPT_PARSE_TOO_DEEP;
+            uint32_t size = lept_tape_load<uint32_t>(p + 1);
+            lept_tape_frame f = {end, size, size, *p == LEPT_TAPE_OBJECT};
+            frames.push_back(f);
+            if (f.object)
+                h.lept_start_object();
+            else
+                h.lept_start_array();
+            end = p + n;
+            n = lept_tape_container_size;
+        }
+        }
+        p += n;
+
+        while (true) // 闭合已经完整的容器，再定位下一个值
+        {
+            if (frames.empty())
+                return p == end ? LEPT_PARSE_OK : LEPT_PARSE_INVALID_VALUE;
+            lept_tape_frame &f = frames.back();
+            if (f.left == 0)
+            {
+                if (p != end)
+                    return LEPT_PARSE_INVALID_VALUE;
+                if (f.object)
+                    h.lept_end_object(f.size);
+                else
+                    h.lept_end_array(f.size);
+                end = f.end;
+                frames.pop_back();
+                continue;
+            }
+            f.left--;
+            if (f.object)
+            {
+                size_t k = lept_tape_string_extent(p, end);
+                if (k == 0)
+                    return LEPT_PARSE_INVALID_VALUE;
+                h.lept_key(p + 4, k - 5);
+                p += k;
+            }
+            break;
+        }
+    }
+}
+
+/** 在上下文 c 中把 [data, data + len) 中的 tape 还原为树，构造出的树移动到 v 中 */
+lept_parse_ret lept_tape_decode_tree(lept_context &c, const char *data, size_t len, lept_value &v)
+{
+    if (len < lept_tape_header_size || lept_tape_load<uint32_t>(data) != lept_tape_magic ||
+        lept_tape_load<uint32_t>(data + 4) != lept_tape_version)
+        return LEPT_PARSE_INVALID_VALUE;
+    lept_value_handler h = {c};
+    lept_parse_ret ret = lept_tape_decode(data + lept_tape_header_size, data + len, c.max_depth, h);
+    if (ret == LEPT_PARSE_OK)
+        v = std::move(c.values.back());
+    return ret;
+}
+
+lept_parse_ret lept_value::lept_decode(lept_value &v, const char *data, size_t len, const lept_parse_options &options)
+{
+    lept_context c;
+    c.max_depth = options.max_depth;
+    c.object_index_min = options.object_index_min;
+    return lept_tape_decode_tree(c, data, len, v);
+}
+
+lept_parse_ret lept_document::lept_decode(const char *data, size_t len)
+{
+    lept_reset();
+
+    lept_context c;
+    c.arena = &arena;
+    c.symbols = symbols;
+    c.max_depth = options.max_depth;
+    c.object_index_min = options.object_index_min;
+    return lept_tape_decode_tree(c, data, len, root);
+}
+
+/************************************************************************************************ */
+
+lept_tape_value::lept_tape_value() : p(NULL), end(NULL), key(NULL)
+{
+}
+
+lept_tape_value lept_tape_value::lept_at(const char *p, const char *end, bool member)
+{
+    lept_tape_value v;
+    const char *key = NULL;
+    if (member)
+    {
+        size_t n = lept_tape_string_extent(p, end);
+        if (n == 0)
+            return v;
+        key = p;
+        p += n;
+    }
+    if (lept_tape_extent(p, end))
+    {
+        v.p = p;
+        v.end = end;
+        v.key = key;
+    }
+    return v;
+}
+
+lept_tape_value lept_tape_value::lept_open(const char *data, size_t len)
+{
+    if (len < lept_tape_header_size || lept_tape_load<uint32_t>(data) != lept_tape_magic ||
+        lept_tape_load<uint32_t>(data + 4) != lept_tape_version)
+        return lept_tape_value();
+    lept_tape_value v = lept_at(data + lept_tape_header_size, data + len, false);
+    if (v.p && lept_tape_extent(v.p, v.end) != len - lept_tape_header_size) // 根值之后不能再有内容
+        return lept_tape_value();
+    return v;
+}
+
+bool lept_tape_value::lept_is_valid() const
+{
+    return p != NULL;
+}
+
+lept_type lept_tape_value::lept_get_type() const
+{
+    if (!p)
+        return LEPT_NULL;
+    switch (*p)
+    {
+    case LEPT_TAPE_FALSE:
+        return LEPT_FALSE;
+    case LEPT_TAPE_TRUE:
+        return LEPT_TRUE;
+    case LEPT_TAPE_DOUBLE:
+    case LEPT_TAPE_INT64:
+    case LEPT_TAPE_UINT64:
+        return LEPT_NUMBER;
+    case LEPT_TAPE_STRING:
+        return LEPT_STRING;
+    case LEPT_TAPE_ARRAY:
+        return LEPT_ARRAY;
+    case LEPT_TAPE_OBJECT:
+        return LEPT_OBJECT;
+    default:
+        return LEPT_NULL;
+    }
+}
+
+bool lept_tape_value::lept_get_boolean() const
+{
+    assert(lept_get_type() == LEPT_TRUE || lept_get_type() == LEPT_FALSE);
+    return *p == LEPT_TAPE_TRUE;
+}
+
+double lept_tape_value::lept_get_number() const
+{
+    assert(lept_get_type() == LEPT_NUMBER);
+    if (*p == LEPT_TAPE_INT64)
+        return (double)lept_tape_load<int64_t>(p + 1);
+    if (*p == LEPT_TAPE_UINT64)
+        return (double)lept_tape_load<uint64_t>(p + 1);
+    return lept_tape_load<double>(p + 1);
+}
+
+bool lept_tape_value::lept_is_int64() const
+{
+    return p && *p == LEPT_TAPE_INT64;
+}
+
+bool lept_tape_value::lept_is_uint64() const
+{
+    return p && (*p == LEPT_TAPE_UINT64 || (*p == LEPT_TAPE_INT64 && lept_tape_load<int64_t>(p + 1) >= 0));
+}
+
+int64_t lept_tape_value::lept_get_int64() const
+{
+    assert(lept_is_int64());
+    return lept_tape_load<int64_t>(p + 1);
+}
+
+uint64_t lept_tape_value::lept_get_uint64() const
+{
+    assert(lept_is_uint64());
+    return lept_tape_load<uint64_t>(p + 1); // 非负的 int64_t 与 uint64_t 的表示相同
+}
+
+const char *lept_tape_value::lept_get_string() const
+{
+    assert(lept_get_type() == LEPT_STRING);
+    return p + 5;
+}
+
+size_t lept_tape_value::lept_get_string_length() const
+{
+    assert(lept_get_type() == LEPT_STRING);
+    return lept_tape_load<uint32_t>(p + 1);
+}
+
+size_t lept_tape_value::lept_get_array_size() const
+{
+    assert(lept_get_type() == LEPT_ARRAY);
+    return lept_tape_load<uint32_t>(p + 1);
+}
+
+lept_tape_value lept_tape_value::lept_array_at(size_t index) const
+{
+    if (lept_get_type() != LEPT_ARRAY)
+        return lept_tape_value();
+    lept_tape_value e = lept_get_first();
+    for (; index && e.p; index--)
+        e = e.lept_get_next();
+    return e;
+}
+
+size_t lept_tape_value::lept_get_object_size() const
+{
+    assert(lept_get_type() == LEPT_OBJECT);
+    return lept_tape_load<uint32_t>(p + 1);
+}
+
+lept_tape_value lept_tape_value::lept_find_object_value(const char *k, size_t len) const
+{
+    if (lept_get_type() != LEPT_OBJECT)
+        return lept_tape_value();
+    lept_tape_value m = lept_get_first();
+    for (; m.p; m = m.lept_get_next())
+        if (lept_tape_load<uint32_t>(m.key) == len && memcmp(m.key + 4, k, len) == 0)
+            break;
+    return m;
+}
+
+lept_tape_value lept_tape_value::lept_find_object_value(const char *k) const
+{
+    return lept_find_object_value(k, strlen(k));
+}
+
+lept_tape_value lept_tape_value::lept_get_first() const
+{
+    lept_type type = lept_get_type();
+    if (type != LEPT_ARRAY && type != LEPT_OBJECT)
+        return lept_tape_value();
+    const char *content = p + lept_tape_container_size;
+    return lept_at(content, content + lept_tape_load<uint64_t>(p + 5), type == LEPT_OBJECT);
+}
+
+lept_tape_value lept_tape_value::lept_get_next() const
+{
+    if (!p)
+        return lept_tape_value();
+    return lept_at(p + lept_tape_extent(p, end), end, key != NULL);
+}
+
+const char *lept_tape_value::lept_get_key() const
+{
+    return key ? key + 4 : NULL;
+}
+
+size_t lept_tape_value::lept_get_key_length() const
+{
+    return key ? lept_tape_load<uint32_t>(key) : 0;
+}
+
+lept_parse_ret lept_tape_value::lept_get_value(lept_value &v, const lept_parse_options &options) const
+{
+    if (!p)
+        return LEPT_PARSE_INVALID_VALUE;
+    lept_context c;
+    lept_value_handler h = {c};
+    lept_parse_ret ret = lept_tape_decode(p, p + lept_tape_extent(p, end), options.max_depth, h);
+    if (ret == LEPT_PARSE_OK)
+        v = std::move(c.values.back());
+    return ret;
+}
+
+/************************************************************************************************ */
+
+lept_tape_file::lept_tape_file() : map(NULL), map_size(0)
+{
+}
+
+lept_tape_file::~lept_tape_file()
+{
+    lept_unmap_file(map, map_size);
+}
+
+lept_parse_ret lept_tape_file::lept_open(const char *path)
+{
+    lept_unmap_file(map, map_size);
+    map = NULL;
+    map_size = 0;
+    root = lept_tape_value();
+    if (!lept_map_file(path, map, map_size))
+    {
+        map = NULL;
+        map_size = 0;
+        return LEPT_PARSE_IO_ERROR;
+    }
+    root = lept_tape_value::lept_open(map, map_size);
+    return root.lept_is_valid() ? LEPT_PARSE_OK : LEPT_PARSE_INVALID_VALUE;
+}
+
+lept_tape_value lept_tape_file::lept_get_root() const
+{
+    return root;
+}
@@ -1,7 +1,15 @@
 #include "leptjson.h"
+#include "leptjson_bind.h"
+#include "leptjson_sax.h"
+#include <clocale>
 #include <cmath>
+#include <cstdio>
 #include <cstring>
 #include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 int main_ret = 0;
 int test_count = 0;
@@ -40,18 +48,20 @@ void expect_eq(const char *expect, const char *actual, const char *file, int lin
 
 #define EXPECT_EQ(expect, actual) expect_eq(expect, actual, __FILE__, __LINE__)
 
+lept_parse_options parse_options; // 解析测试使用的选项，test_engine 以各个引擎重复这些测试
+
 #define TEST_ERROR(error, json)                                                                                        \
     do                                                                                                                 \
     {                                                                                                                  \
         lept_value v;                                                                                                  \
-        EXPECT_EQ(error, lept_value::lept_parse(v, json));                                                             \
+        EXPECT_EQ(error, lept_value::lept_parse(v, json, parse_options));                                              \
     } while (0)
 
 #define TEST_NUMBER(expect, json)                                                                                      \
     do                                                                                                                 \
     {                                                                                                                  \
         lept_value v;                                                                                                  \
-        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, json));                                                     \
+        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, json, parse_options));                                      \
         EXPECT_EQ(LEPT_NUMBER, v.lept_get_type());                                                                     \
         EXPECT_EQ(expect, v.lept_get_number());                                                                        \
     } while (0)
@@ -60,11 +70,21 @@ void expect_eq(const char *expect, const char *actual, const char *file, int lin
     do                                                                                                                 \
     {                                                                                                                  \
         lept_value v;                                                                                                  \
-        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, json));                                                     \
+        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, json, parse_options));                                      \
         EXPECT_EQ(LEPT_STRING, v.lept_get_type());                                                                     \
         EXPECT_EQ(expect, v.lept_get_string());                                                                        \
     } while (0)
 
+#define TEST_ROUNDTRIP(json)                                                                                           \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        lept_value v;                                                                                                  \
+        lept_buffer b;                                                                                                 \
+        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, json, parse_options));                                      \
+        lept_value::lept_stringify(v, b);                                                                              \
+        EXPECT_EQ(json, b.lept_get_data());                                                                            \
+    } while (0)
+
 /************************************************************************************** */
 
 /** 测试与null相关的内容 */
@@ -73,7 +93,7 @@ void test_parse_null()
 #if 1 // 解析null值
     {
         lept_value v;
-        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, "null"));
+        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, "null", parse_options));
         EXPECT_EQ(LEPT_NULL, v.lept_get_type());
     }
 #endif
@@ -91,7 +111,7 @@ void test_parse_true()
 {
     lept_value v;
     v.lept_set_boolean(false);
-    EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, "true"));
+    EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, "true", parse_options));
     EXPECT_EQ(LEPT_TRUE, v.lept_get_type());
     EXPECT_EQ(true, v.lept_get_boolean());
 }
@@ -101,7 +121,7 @@ void test_parse_false()
 {
     lept_value v;
     v.lept_set_boolean(true);
-    EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, "false"));
+    EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, "false", parse_options));
     EXPECT_EQ(LEPT_FALSE, v.lept_get_type());
     EXPECT_EQ(false, v.lept_get_boolean());
 }
@@ -182,14 +202,99 @@ void test_parse_number()
     TEST_ERROR(LEPT_PARSE_NUMBER_TOO_BIG, "-1e309");
 #endif
 
+#if 1 // 结果须为最接近的 double，逐位比较
+    {
+        const char *json[] = {"0.1", "9007199254740993", "123456789012345678901234567890", "1e23",
+                              "2.2250738585072011e-308", "2.4703282292062328e-324", "8.988465674311579e+307",
+                              "1.00000000000000011102230246251565404236316680908203125",
+                              "1.00000000000000011102230246251565404236316680908203126"};
+        const double expect[] = {0.1, 9007199254740992.0, 1.2345678901234568e+29, 1e23,
+                                 2.225073858507201e-308, 5e-324, 8.988465674311579e+307,
+                                 1.0, 1.0000000000000002};
+        for (size_t i = 0; i < sizeof(json) / sizeof(json[0]); i++)
+        {
+            lept_value v;
+            EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, json[i], parse_options));
+            EXPECT_EQ(true, v.lept_get_number() == expect[i]);
+        }
+    }
+#endif
+
+#if 1 // 与区域设置无关
+    if (setlocale(LC_NUMERIC, "de_DE.UTF-8") || setlocale(LC_NUMERIC, "fr_FR.UTF-8"))
+    {
+        TEST_NUMBER(1.5, "1.5");
+        TEST_NUMBER(1.2345678901234567e-300, "1.2345678901234567e-300");
+        setlocale(LC_NUMERIC, "C");
+    }
+#endif
+
 #if 1 // 访问number
     lept_value v;
     v.lept_set_number(-0.12);
-    EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, "12.788"));
+    EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, "12.788", parse_options));
     EXPECT_EQ(12.788, v.lept_get_number());
 #endif
 }
 
+/** 测试以 64 位整数保存的数字 */
+void test_parse_integer()
+{
+#if 1 // 没有小数与指数部分的整数精确保存
+    {
+        lept_value v;
+        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, "9007199254740993", parse_options));
+        EXPECT_EQ(true, v.lept_is_int64());
+        EXPECT_EQ((int64_t)9007199254740993LL, v.lept_get_int64());
+        EXPECT_EQ(9007199254740992.0, v.lept_get_number());
+
+        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, "9223372036854775807", parse_options));
+        EXPECT_EQ(INT64_MAX, v.lept_get_int64());
+        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, "-9223372036854775808", parse_options));
+        EXPECT_EQ(INT64_MIN, v.lept_get_int64());
+        EXPECT_EQ(false, v.lept_is_uint64());
+
+        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, "18446744073709551615", parse_options));
+        EXPECT_EQ(false, v.lept_is_int64());
+        EXPECT_EQ(true, v.lept_is_uint64());
+        EXPECT_EQ(UINT64_MAX, v.lept_get_uint64());
+
+        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, "-123", parse_options));
+        EXPECT_EQ((int64_t)-123, v.lept_get_int64());
+        EXPECT_EQ(-123.0, v.lept_get_number());
+    }
+#endif
+
+#if 1 // 其余情况按 double 保存
+    {
+        const char *json[] = {"18446744073709551616", "-9223372036854775809", "1.0", "1e2", "-0"};
+        for (size_t i = 0; i < sizeof(json) / sizeof(json[0]); i++)
+        {
+            lept_value v;
+            EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, json[i], parse_options));
+            EXPECT_EQ(LEPT_NUMBER, v.lept_get_type());
+            EXPECT_EQ(false, v.lept_is_int64() || v.lept_is_uint64());
+        }
+        lept_value v;
+        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, "-0", parse_options));
+        EXPECT_EQ(true, std::signbit(v.lept_get_number()));
+    }
+#endif
+
+#if 1 // 设置与拷贝
+    {
+        lept_value v;
+        v.lept_set_uint64(42);
+        EXPECT_EQ(true, v.lept_is_int64());
+        v.lept_set_int64(-5);
+        lept_value c = v;
+        EXPECT_EQ((int64_t)-5, c.lept_get_int64());
+        v.lept_set_number(1.5);
+        EXPECT_EQ(false, v.lept_is_int64());
+    }
+#endif
+}
+
 void test_parse_string()
 {
 #if 1 // 常规测试
@@ -221,7 +326,7 @@ void test_parse_string()
 
 #if 1 // 访问字符串
     lept_value v;
-    EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, "\"Hello world\\n\""));
+    EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, "\"Hello world\\n\"", parse_options));
     EXPECT_EQ("Hello world\n", v.lept_get_string());
 #endif
 
@@ -249,21 +354,160 @@ void test_parse_string()
 #endif
 }
 
+/** 在各个 SIMD 级别下测试字符串解析，特殊字符出现在块内的各个位置 */
+void test_parse_string_simd()
+{
+    lept_simd_level max = lept_get_simd_level();
+    for (int level = LEPT_SIMD_NONE; level <= max; level++)
+    {
+        EXPECT_EQ((lept_simd_level)level, lept_set_simd_level((lept_simd_level)level));
+        test_parse_string();
+
+        int ok = 0, total = 0;
+        for (int n = 0; n < 80; n++)
+        {
+            std::string body(n, 'x');
+            std::string json = "\"" + body + "\\n" + body + "\"";
+            lept_value v;
+            total++;
+            if (lept_value::lept_parse(v, json.c_str()) == LEPT_PARSE_OK && v.lept_get_string() == body + "\n" + body)
+                ok++;
+
+            json = "\"" + body + "\x01" + body + "\"";
+            total++;
+            if (lept_value::lept_parse(v, json.c_str()) == LEPT_PARSE_INVALID_STRING_CHAR)
+                ok++;
+
+            json = "\"" + body;
+            total++;
+            if (lept_value::lept_parse(v, json.c_str()) == LEPT_PARSE_MISS_QUOTATION_MARK)
+                ok++;
+
+            json = "\"" + body + "\xE4\xB8\xAD\"";
+            total++;
+            if (lept_value::lept_parse(v, json.c_str()) == LEPT_PARSE_OK && v.lept_get_string_length() == (size_t)n + 3)
+                ok++;
+        }
+        EXPECT_EQ(total, ok);
+    }
+
+#if 1 // 解析的同时在另一个线程切换级别，结果不变
+    std::string json = "[";
+    for (int i = 0; i < 200; i++)
+        json += (i ? ",\"" : "\"") + std::string(i % 70, 'x') + "\\t\"";
+    json += "]";
+    int ok = 0;
+    std::thread parser([&] {
+        for (int i = 0; i < 200; i++)
+        {
+            lept_value v;
+            ok += lept_value::lept_parse(v, json) == LEPT_PARSE_OK && v.lept_get_array_size() == 200;
+        }
+    });
+    for (int i = 0; i < 200; i++)
+        lept_set_simd_level((lept_simd_level)(i % (max + 1)));
+    parser.join();
+    EXPECT_EQ(200, ok);
+#endif
+    lept_set_simd_level(max);
+}
+
+void test_parse_length()
+{
+    /* 从没有 '\0' 结尾的堆内存解析，越界读取会被 sanitizer 发现 */
+    auto parse = [](lept_value &v, const char *json, size_t len) {
+        char *buf = new char[len ? len : 1];
+        memcpy(buf, json, len);
+        lept_parse_ret ret = lept_value::lept_parse(v, buf, len, parse_options);
+        delete[] buf;
+        return ret;
+    };
+
+    lept_value v;
+    EXPECT_EQ(LEPT_PARSE_OK, parse(v, "[1,2]xyz", 5));
+    EXPECT_EQ((size_t)2, v.lept_get_array_size());
+    EXPECT_EQ(LEPT_PARSE_OK, parse(v, "truex", 4));
+    EXPECT_EQ(LEPT_TRUE, v.lept_get_type());
+    EXPECT_EQ(LEPT_PARSE_OK, parse(v, "123456", 3));
+    EXPECT_EQ(123.0, v.lept_get_number());
+    EXPECT_EQ(LEPT_PARSE_OK, parse(v, "\"abc\"", 5));
+    EXPECT_EQ("abc", v.lept_get_string());
+
+    EXPECT_EQ(LEPT_PARSE_EXPECT_VALUE, parse(v, "", 0));
+    EXPECT_EQ(LEPT_PARSE_EXPECT_VALUE, parse(v, "  ", 2));
+    EXPECT_EQ(LEPT_PARSE_INVALID_VALUE, parse(v, "null", 3));
+    EXPECT_EQ(LEPT_PARSE_INVALID_VALUE, parse(v, "1.5", 2));
+    EXPECT_EQ(LEPT_PARSE_INVALID_VALUE, parse(v, "1e5", 2));
+    EXPECT_EQ(LEPT_PARSE_MISS_QUOTATION_MARK, parse(v, "\"abc\"", 4));
+    EXPECT_EQ(LEPT_PARSE_INVALID_STRING_ESCAPE, parse(v, "\"\\n\"", 2));
+    EXPECT_EQ(LEPT_PARSE_INVALID_UNICODE_HEX, parse(v, "\"\\u0041\"", 5));
+    EXPECT_EQ(LEPT_PARSE_INVALID_UNICODE_SURROGATE, parse(v, "\"\\uD834\\uDD1E\"", 8));
+    EXPECT_EQ(LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, parse(v, "[1,2]", 4));
+    EXPECT_EQ(LEPT_PARSE_MISS_KEY, parse(v, "{\"a\":1,}", 7));
+    EXPECT_EQ(LEPT_PARSE_MISS_COLON, parse(v, "{\"a\":1}", 4));
+    EXPECT_EQ(LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET, parse(v, "{\"a\":1}", 6));
+
+    /* 长度以内的 '\0' 是普通字符，不再表示文本结束 */
+    EXPECT_EQ(LEPT_PARSE_ROOT_NOT_SINGULAR, lept_value::lept_parse(v, "null\0", 5, parse_options));
+    EXPECT_EQ(LEPT_PARSE_INVALID_VALUE, lept_value::lept_parse(v, "\0", 1, parse_options));
+    EXPECT_EQ(LEPT_PARSE_INVALID_STRING_CHAR, lept_value::lept_parse(v, "\"a\0b\"", 5, parse_options));
+
+    /* 字符串中可以包含 \u0000 */
+    EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, "\"a\\u0000b\"", parse_options));
+    EXPECT_EQ((size_t)3, v.lept_get_string_length());
+    EXPECT_EQ(0, memcmp(v.lept_get_string(), "a\0b", 4));
+    lept_buffer b;
+    lept_value::lept_stringify(v, b);
+    EXPECT_EQ("\"a\\u0000b\"", b.lept_get_data());
+    v.lept_set_string("x\0y", 3);
+    EXPECT_EQ((size_t)3, v.lept_get_string_length());
+
+    /* 提供 data() 与 size() 的字符串类型 */
+    std::string s("[\"a\", {\"b\": false}]");
+    EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, s, parse_options));
+    EXPECT_EQ((size_t)2, v.lept_get_array_size());
+    lept_document d;
+    d.lept_set_options(parse_options);
+    EXPECT_EQ(LEPT_PARSE_OK, d.lept_parse(s));
+    EXPECT_EQ(LEPT_ARRAY, d.lept_get_root().lept_get_type());
+    EXPECT_EQ(LEPT_PARSE_OK, d.lept_parse("{}junk", 2));
+    EXPECT_EQ(LEPT_OBJECT, d.lept_get_root().lept_get_type());
+
+    /* 每个 SIMD 级别都不能读过长字符串的末尾 */
+    lept_simd_level max = lept_get_simd_level();
+    for (int level = LEPT_SIMD_NONE; level <= max; level++)
+    {
+        lept_set_simd_level((lept_simd_level)level);
+        int ok = 0, total = 0;
+        for (int n = 0; n < 80; n++)
+        {
+            std::string json = "\"" + std::string(n, 'x') + "\"";
+            total += 2;
+            if (parse(v, json.data(), json.size()) == LEPT_PARSE_OK && v.lept_get_string_length() == (size_t)n)
+                ok++;
+            if (parse(v, json.data(), json.size() - 1) == LEPT_PARSE_MISS_QUOTATION_MARK)
+                ok++;
+        }
+        EXPECT_EQ(total, ok);
+    }
+    lept_set_simd_level(max);
+}
+
 void test_parse_array()
 {
 #if 1
     {
         lept_value v;
-        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, "[ ]"));
+        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, "[ ]", parse_options));
         EXPECT_EQ(LEPT_ARRAY, v.lept_get_type());
-        EXPECT_EQ((std::vector<lept_value>::size_type)0, v.a.size());
+        EXPECT_EQ((size_t)0, v.lept_get_array_size());
     }
 #endif
 
 #if 1
     {
         lept_value v;
-        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, "[ null , false , true , 123 , \"abc\" ]"));
+        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, "[ null , false , true , 123 , \"abc\" ]", parse_options));
         EXPECT_EQ(LEPT_ARRAY, v.lept_get_type());
 
         lept_value e0 = v.lept_get_array_element(0);
@@ -290,23 +534,24 @@ void test_parse_array()
 #if 1
     {
         lept_value v;
-        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, "[ [ ] , [ 0 ] , [ 0 , 1 ] , [ 0 , 1 , 2 ] ]"));
+        EXPECT_EQ(LEPT_PARSE_OK,
+                  lept_value::lept_parse(v, "[ [ ] , [ 0 ] , [ 0 , 1 ] , [ 0 , 1 , 2 ] ]", parse_options));
         EXPECT_EQ(LEPT_ARRAY, v.lept_get_type());
 
         lept_value e0 = (v.lept_get_array_element(0));
         EXPECT_EQ(LEPT_ARRAY, e0.lept_get_type());
-        EXPECT_EQ((std::vector<lept_value>::size_type)0, e0.a.size());
+        EXPECT_EQ((size_t)0, e0.lept_get_array_size());
 
         lept_value e1 = (v.lept_get_array_element(1));
         EXPECT_EQ(LEPT_ARRAY, e1.lept_get_type());
-        EXPECT_EQ((std::vector<lept_value>::size_type)1, e1.a.size());
+        EXPECT_EQ((size_t)1, e1.lept_get_array_size());
         lept_value e1e0 = (e1.lept_get_array_element(0));
         EXPECT_EQ(LEPT_NUMBER, e1e0.lept_get_type());
         EXPECT_EQ(0., e1e0.lept_get_number());
 
         lept_value e2 = (v.lept_get_array_element(2));
         EXPECT_EQ(LEPT_ARRAY, e2.lept_get_type());
-        EXPECT_EQ((std::vector<lept_value>::size_type)2, e2.a.size());
+        EXPECT_EQ((size_t)2, e2.lept_get_array_size());
         lept_value e2e0 = (e2.lept_get_array_element(0));
         EXPECT_EQ(LEPT_NUMBER, e2e0.lept_get_type());
         EXPECT_EQ(0., e2e0.lept_get_number());
@@ -316,7 +561,7 @@ void test_parse_array()
 
         lept_value e3 = (v.lept_get_array_element(3));
         EXPECT_EQ(LEPT_ARRAY, e3.lept_get_type());
-        EXPECT_EQ((std::vector<lept_value>::size_type)3, e3.a.size());
+        EXPECT_EQ((size_t)3, e3.lept_get_array_size());
         lept_value e3e0 = (e3.lept_get_array_element(0));
         EXPECT_EQ(LEPT_NUMBER, e3e0.lept_get_type());
         EXPECT_EQ(0., e3e0.lept_get_number());
@@ -355,10 +600,1601 @@ void test_parse_object()
     TEST_ERROR(LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET, "{\"a\":1 \"b\"");
     TEST_ERROR(LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET, "{\"a\":{}");
 #endif
+
+#if 1 // 访问对象
+    {
+        lept_value v;
+        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, "{ \"n\" : null , \"s\" : \"abc\" , \"a\" : [ 1 , 2 ] }",
+                                                        parse_options));
+        EXPECT_EQ(LEPT_OBJECT, v.lept_get_type());
+
+        lept_value k;
+        k.lept_set_string("s");
+        lept_value s = v.lept_get_object_value(k);
+        EXPECT_EQ(LEPT_STRING, s.lept_get_type());
+        EXPECT_EQ("abc", s.lept_get_string());
+
+        k.lept_set_string("a");
+        lept_value a = v.lept_get_object_value(k);
+        EXPECT_EQ(LEPT_ARRAY, a.lept_get_type());
+        EXPECT_EQ((size_t)2, a.lept_get_array_size());
+        EXPECT_EQ(2., a.lept_get_array_element(1).lept_get_number());
+
+        k.lept_set_string("x");
+        EXPECT_EQ(LEPT_NULL, v.lept_get_object_value(k).lept_get_type());
+    }
+#endif
+}
+
+/** 测试返回引用或指针的访问接口 */
+void test_access()
+{
+#if 1 // 只读访问
+    {
+        lept_document d;
+        d.lept_set_options(parse_options);
+        EXPECT_EQ(LEPT_PARSE_OK, d.lept_parse("{ \"a\" : { \"b\" : [ 1 , 2 , 3 ] } , \"c\" : \"d\" , \"e\" : null }"));
+        const lept_value &root = d.lept_get_root();
+        EXPECT_EQ((size_t)3, root.lept_get_object_size());
+
+        const lept_value *b = root.lept_find_object_value("a")->lept_find_object_value("b");
+        EXPECT_EQ((size_t)3, b->lept_get_array_size());
+        EXPECT_EQ(3., b->lept_array_at(2).lept_get_number());
+
+        double sum = 0;
+        for (const lept_value *e = b->lept_array_begin(); e != b->lept_array_end(); e++)
+            sum += e->lept_get_number();
+        EXPECT_EQ(6., sum);
+
+        EXPECT_EQ(true, root.lept_find_object_value("x") == NULL);
+        EXPECT_EQ(true, root.lept_find_object_value("a\0", 2) == NULL);
+        EXPECT_EQ(LEPT_NULL, root.lept_find_object_value("e")->lept_get_type());
+    }
+#endif
+
+#if 1 // 按插入顺序遍历成员
+    {
+        lept_value v;
+        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, "{ \"z\" : 1 , \"y\" : 2 , \"x\" : 3 }", parse_options));
+        std::string keys;
+        for (const lept_member *m = v.lept_object_begin(); m != v.lept_object_end(); m++)
+            keys += m->k.lept_get_string();
+        EXPECT_EQ("zyx", keys.c_str());
+        EXPECT_EQ("y", v.lept_get_object_member(1).k.lept_get_string());
+        EXPECT_EQ(2., v.lept_get_object_member(1).v.lept_get_number());
+    }
+#endif
+
+#if 1 // 通过引用修改
+    {
+        lept_value v;
+        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, "{ \"a\" : [ 1 , [ 2 ] ] }", parse_options));
+        lept_value &a = *v.lept_find_object_value("a");
+        a.lept_array_at(0).lept_set_string("one");
+        a.lept_array_at(0) = a.lept_array_at(1); // 将兄弟节点拷贝过来
+        a.lept_array_at(1) = a.lept_array_at(1).lept_array_at(0); // 用子节点替换自身
+        EXPECT_EQ(2., v.lept_find_object_value("a")->lept_array_at(0).lept_array_at(0).lept_get_number());
+        EXPECT_EQ(2., v.lept_find_object_value("a")->lept_array_at(1).lept_get_number());
+    }
+#endif
+}
+
+/** 测试成员较多的对象的键查找 */
+void test_object_index()
+{
+    std::string json = "{";
+    for (int i = 0; i < 100; i++)
+        json += (i ? ",\"k" : "\"k") + std::to_string(i) + "\":" + std::to_string(i);
+    json += ",\"k7\":-1}"; // 重复的键以第一个为准
+
+#if 1
+    {
+        lept_value v;
+        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, json.c_str(), parse_options));
+        EXPECT_EQ((size_t)101, v.lept_get_object_size());
+        lept_value c = v;
+        int found = 0;
+        for (int i = 0; i < 100; i++)
+        {
+            std::string k = "k" + std::to_string(i);
+            const lept_value *e = v.lept_find_object_value(k.c_str());
+            const lept_value *ce = c.lept_find_object_value(k.c_str());
+            if (e && ce && e->lept_get_number() == i && ce->lept_get_number() == i)
+                found++;
+        }
+        EXPECT_EQ(100, found);
+        EXPECT_EQ(true, v.lept_find_object_value("k100") == NULL);
+        EXPECT_EQ(true, v.lept_find_object_value("k1", 1) == NULL);
+        EXPECT_EQ("k99", v.lept_get_object_member(99).k.lept_get_string()); // 保持插入顺序
+    }
+#endif
+
+#if 1
+    {
+        lept_document d;
+        d.lept_set_options(parse_options);
+        EXPECT_EQ(LEPT_PARSE_OK, d.lept_parse(json.c_str()));
+        EXPECT_EQ(42., d.lept_get_root().lept_find_object_value("k42")->lept_get_number());
+    }
+#endif
+
+#if 1
+    {
+        /* 索引按选项建立：不建立时查找逐个比较键，结果相同；拷贝保留源对象是否带有索引 */
+        lept_value v, plain;
+        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, json, parse_options));
+        EXPECT_EQ((int)LEPT_FLAG_INDEXED, v.flags & LEPT_FLAG_INDEXED);
+        lept_parse_options options = parse_options;
+        options.object_index_min = 0;
+        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(plain, json, options));
+        EXPECT_EQ(0, plain.flags & LEPT_FLAG_INDEXED);
+        lept_value c = plain;
+        EXPECT_EQ(0, c.flags & LEPT_FLAG_INDEXED);
+        EXPECT_EQ(7., c.lept_find_object_value("k7")->lept_get_number());
+        EXPECT_EQ(99., plain.lept_find_object_value("k99")->lept_get_number());
+
+        lept_document d;
+        d.lept_set_options(options);
+        EXPECT_EQ(LEPT_PARSE_OK, d.lept_parse(json));
+        EXPECT_EQ(0, d.lept_get_root().flags & LEPT_FLAG_INDEXED);
+        EXPECT_EQ(42., d.lept_get_root().lept_find_object_value("k42")->lept_get_number());
+
+        options.object_index_min = 2;
+        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(plain, "{\"a\":1,\"b\":2}", options));
+        EXPECT_EQ((int)LEPT_FLAG_INDEXED, plain.flags & LEPT_FLAG_INDEXED);
+        EXPECT_EQ(2., plain.lept_find_object_value("b")->lept_get_number());
+        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(plain, "{\"a\":1}", options));
+        EXPECT_EQ(0, plain.flags & LEPT_FLAG_INDEXED);
+
+        v.lept_object_value_at(3).lept_set_number(-3); // 值可以修改，键与索引不受影响
+        EXPECT_EQ(-3., v.lept_find_object_value("k3")->lept_get_number());
+        EXPECT_EQ("k3", v.lept_get_object_member(3).k.lept_get_string());
+    }
+#endif
+}
+
+/** 测试深层嵌套 */
+void test_parse_nested()
+{
+    const int depth = 1000;
+
+#if 1 // [[[...[1]...]]]
+    {
+        std::string json = std::string(depth, '[') + "1" + std::string(depth, ']');
+        lept_value v;
+        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, json.c_str(), parse_options));
+        const lept_value *e = &v;
+        for (int i = 0; i < depth; i++)
+        {
+            EXPECT_EQ(LEPT_ARRAY, e->lept_get_type());
+            EXPECT_EQ((size_t)1, e->lept_get_array_size());
+            e = &e->lept_array_at(0);
+        }
+        EXPECT_EQ(1., e->lept_get_number());
+    }
+#endif
+
+#if 1 // {"a":{"a":...{"a":"x"}...}}
+    {
+        std::string json;
+        for (int i = 0; i < depth; i++)
+            json += "{\"a\":";
+        json += "\"x\"" + std::string(depth, '}');
+        lept_value v;
+        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, json.c_str(), parse_options));
+        const lept_value *e = &v;
+        for (int i = 0; i < depth && e; i++)
+        {
+            EXPECT_EQ(LEPT_OBJECT, e->lept_get_type());
+            e = e->lept_find_object_value("a");
+        }
+        EXPECT_EQ("x", e->lept_get_string());
+    }
+#endif
+}
+
+/** 测试值的存储布局与拷贝、移动语义 */
+void test_value()
+{
+#if 1 // 每个节点固定 16 字节
+    EXPECT_EQ((size_t)16, sizeof(lept_value));
+#endif
+
+#if 1 // 深拷贝
+    {
+        lept_value v;
+        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, "[ \"abc\" , [ 1 ] ]"));
+        lept_value c = v;
+        v.lept_set_number(1.0);
+        EXPECT_EQ(LEPT_ARRAY, c.lept_get_type());
+        EXPECT_EQ("abc", c.lept_get_array_element(0).lept_get_string());
+        EXPECT_EQ((size_t)3, c.lept_get_array_element(0).lept_get_string_length());
+    }
+#endif
+
+#if 1 // 移动后源值为 null
+    {
+        lept_value v;
+        v.lept_set_string("Hello");
+        lept_value m = std::move(v);
+        EXPECT_EQ(LEPT_NULL, v.lept_get_type());
+        EXPECT_EQ("Hello", m.lept_get_string());
+    }
+#endif
+
+#if 1 // 将子节点赋值给自身
+    {
+        lept_value v;
+        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, "[ [ \"x\" ] ]"));
+        v = v.lept_get_array_element(0);
+        EXPECT_EQ("x", v.lept_get_array_element(0).lept_get_string());
+    }
+#endif
+}
+
+/** 测试由 arena 承载的文档 */
+/** 把事件记录成文本的处理器 */
+struct record_handler
+{
+    std::string events;
+
+    void lept_null() { events += "null "; }
+    void lept_boolean(bool b) { events += b ? "true " : "false "; }
+    void lept_number(double n) { events += "d" + std::to_string(n) + " "; }
+    void lept_int64(int64_t i) { events += "i" + std::to_string(i) + " "; }
+    void lept_uint64(uint64_t u) { events += "u" + std::to_string(u) + " "; }
+    void lept_string(const char *s, size_t len) { events += "s:" + std::string(s, len) + " "; }
+    void lept_start_array() { events += "[ "; }
+    void lept_end_array(size_t n) { events += "]" + std::to_string(n) + " "; }
+    void lept_start_object() { events += "{ "; }
+    void lept_key(const char *s, size_t len) { events += "k:" + std::string(s, len) + " "; }
+    void lept_end_object(size_t n) { events += "}" + std::to_string(n) + " "; }
+};
+
+#define TEST_EVENTS(expect, json)                                                                                      \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        record_handler h;                                                                                              \
+        EXPECT_EQ(LEPT_PARSE_OK, lept_parse_events(json, strlen(json), h));                                            \
+        EXPECT_EQ(std::string(expect), h.events);                                                                      \
+    } while (0)
+
+void test_lazy()
+{
+    const char *json = " { \"skip\" : [ \"]\", { \"}\" : \"\\\"\" } ], \"n\" : 1.5, \"s\" : \"a\\nb\", "
+                       "\"k\\u0065y\" : true, \"arr\" : [ null, [ 1, 2 ], { \"x\" : -3 } ], \"bad\" : [ 1 2 ] } ";
+    lept_lazy_value doc = lept_lazy_value::lept_parse(json);
+    EXPECT_EQ(LEPT_OBJECT, doc.lept_get_type());
+
+    lept_value v;
+    EXPECT_EQ(LEPT_PARSE_OK, doc.lept_find_object_value("n").lept_get_value(v));
+    EXPECT_EQ(1.5, v.lept_get_number());
+    EXPECT_EQ(LEPT_PARSE_OK, doc.lept_find_object_value("s").lept_get_value(v));
+    EXPECT_EQ("a\nb", v.lept_get_string());
+    EXPECT_EQ(LEPT_TRUE, doc.lept_find_object_value("key").lept_get_type()); // 键中的转义解码后比较
+
+    lept_lazy_value arr = doc.lept_find_object_value("arr");
+    EXPECT_EQ(LEPT_ARRAY, arr.lept_get_type());
+    EXPECT_EQ(LEPT_NULL, arr.lept_array_at(0).lept_get_type());
+    EXPECT_EQ(true, arr.lept_array_at(0).lept_is_valid());
+    EXPECT_EQ(LEPT_PARSE_OK, arr.lept_array_at(1).lept_array_at(1).lept_get_value(v));
+    EXPECT_EQ((int64_t)2, v.lept_get_int64());
+    EXPECT_EQ(LEPT_PARSE_OK, arr.lept_array_at(2).lept_find_object_value("x").lept_get_value(v));
+    EXPECT_EQ((int64_t)-3, v.lept_get_int64());
+    EXPECT_EQ(LEPT_PARSE_OK, arr.lept_array_at(1).lept_get_value(v));
+    EXPECT_EQ((size_t)2, v.lept_get_array_size());
+
+    /* 不存在与类型不符 */
+    EXPECT_EQ(false, doc.lept_find_object_value("none").lept_is_valid());
+    EXPECT_EQ(LEPT_PARSE_OK, doc.lept_find_object_value("none").lept_get_error());
+    EXPECT_EQ(false, arr.lept_array_at(3).lept_is_valid());
+    EXPECT_EQ(false, arr.lept_find_object_value("n").lept_is_valid());
+    EXPECT_EQ(false, doc.lept_find_object_value("none").lept_array_at(0).lept_is_valid());
+    EXPECT_EQ(LEPT_PARSE_INVALID_VALUE, doc.lept_find_object_value("none").lept_get_value(v));
+
+    /* 只有访问到的部分才会发现错误，错误沿访问链传递 */
+    lept_lazy_value bad = doc.lept_find_object_value("bad");
+    EXPECT_EQ(LEPT_PARSE_OK, bad.lept_array_at(0).lept_get_value(v));
+    EXPECT_EQ(LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, bad.lept_array_at(1).lept_get_error());
+    EXPECT_EQ(LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, bad.lept_array_at(1).lept_array_at(0).lept_get_error());
+    EXPECT_EQ(LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, bad.lept_get_value(v));
+
+    EXPECT_EQ(LEPT_PARSE_EXPECT_VALUE, lept_lazy_value::lept_parse("  ").lept_get_error());
+    lept_lazy_value broken = lept_lazy_value::lept_parse("{\"a\":[1,\"x], \"b\":2}");
+    EXPECT_EQ(LEPT_PARSE_OK, broken.lept_find_object_value("a").lept_get_error());
+    EXPECT_EQ(LEPT_PARSE_MISS_QUOTATION_MARK, broken.lept_find_object_value("b").lept_get_error());
+    EXPECT_EQ(LEPT_PARSE_MISS_COLON, lept_lazy_value::lept_parse("{\"a\" 1}").lept_find_object_value("b").lept_get_error());
+    EXPECT_EQ(LEPT_PARSE_MISS_KEY, lept_lazy_value::lept_parse("{\"a\":1,}").lept_find_object_value("b").lept_get_error());
+    EXPECT_EQ(LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET,
+              lept_lazy_value::lept_parse("{\"a\":{\"b\":1}").lept_find_object_value("b").lept_get_error());
+}
+
+void test_parse_insitu()
+{
+    char json[] = "[ \"abc\", \"a\\nb\\tc\", \"\\u00A2\\u20AC\\uD834\\uDD1E!\", { \"k\\\"ey\" : \"\" } ]";
+    const char *begin = json, *end = json + sizeof(json);
+    lept_document d;
+    d.lept_set_options(parse_options);
+    EXPECT_EQ(LEPT_PARSE_OK, d.lept_parse_insitu(json));
+    const lept_value &root = d.lept_get_root();
+    EXPECT_EQ("abc", root.lept_get_array_element(0).lept_get_string());
+    EXPECT_EQ("a\nb\tc", root.lept_get_array_element(1).lept_get_string());
+    EXPECT_EQ("\xC2\xA2\xE2\x82\xAC\xF0\x9D\x84\x9E!", root.lept_get_array_element(2).lept_get_string());
+    EXPECT_EQ((size_t)10, root.lept_get_array_element(2).lept_get_string_length());
+    const lept_value *v = root.lept_get_array_element(3).lept_find_object_value("k\"ey");
+    EXPECT_EQ(true, v != NULL);
+    for (size_t i = 0; i < 3; i++) // 字符串直接引用输入
+    {
+        const char *s = root.lept_array_at(i).lept_get_string();
+        EXPECT_EQ(true, s > begin && s < end);
+    }
+
+    /* 错误码与复制解析相同 */
+    const char *errors[] = {"\"abc", "\"\\v\"", "\"\x01\"", "\"\\u12\"", "\"\\uD800\"", "\"\\uD800\\uE000\"",
+                            "[\"a\" \"b\"]", "{\"a\\n\" 1}", "\"a\\n\"x"};
+    for (const char *e : errors)
+    {
+        lept_value expect;
+        std::string buf(e);
+        EXPECT_EQ(lept_value::lept_parse(expect, e, parse_options), d.lept_parse_insitu(&buf[0], buf.size()));
+    }
+
+    /* 事件中的字符串同样指向输入 */
+    char events[] = "{\"x\\ty\": [\"\\/\"]}";
+    record_handler h;
+    EXPECT_EQ(LEPT_PARSE_OK, lept_parse_events_insitu(events, strlen(events), h));
+    EXPECT_EQ(std::string("{ k:x\ty [ s:/ ]1 }1 "), h.events);
+}
+
+void test_parse_file()
+{
+    const char *path = "test_parse_file.json";
+    const char *json = "{ \"plain\" : \"abc\", \"escaped\" : \"a\\nb\", \"list\" : [ \"x\", 1, \"\" ] }";
+    FILE *f = fopen(path, "wb");
+    fputs(json, f);
+    fclose(f);
+
+    lept_value v;
+    EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse_file(v, path, parse_options));
+    EXPECT_EQ("abc", v.lept_find_object_value("plain")->lept_get_string());
+
+    for (int mode = LEPT_FILE_COPY; mode <= LEPT_FILE_REFERENCE; mode++)
+    {
+        lept_document d;
+        d.lept_set_options(parse_options);
+        EXPECT_EQ(LEPT_PARSE_OK, d.lept_parse_file(path, (lept_file_mode)mode));
+        const lept_value &root = d.lept_get_root();
+        EXPECT_EQ("abc", root.lept_find_object_value("plain")->lept_get_string());
+        EXPECT_EQ("a\nb", root.lept_find_object_value("escaped")->lept_get_string());
+        const lept_value &list = *root.lept_find_object_value("list");
+        EXPECT_EQ("x", list.lept_get_array_element(0).lept_get_string());
+        EXPECT_EQ((size_t)0, list.lept_get_array_element(2).lept_get_string_length());
+        lept_buffer b1, b2;
+        lept_value::lept_stringify(root, b1);
+        lept_value::lept_stringify(v, b2);
+        EXPECT_EQ(b2.lept_get_data(), b1.lept_get_data());
+    }
+
+    /* 引用模式只改写映射，文件本身不变 */
+    char content[256] = {0};
+    f = fopen(path, "rb");
+    EXPECT_EQ(strlen(json), fread(content, 1, sizeof(content) - 1, f));
+    fclose(f);
+    EXPECT_EQ(json, (const char *)content);
+
+    f = fopen(path, "wb");
+    fclose(f);
+    EXPECT_EQ(LEPT_PARSE_EXPECT_VALUE, lept_value::lept_parse_file(v, path, parse_options));
+    remove(path);
+    EXPECT_EQ(LEPT_PARSE_IO_ERROR, lept_value::lept_parse_file(v, path, parse_options));
+    lept_document d;
+    d.lept_set_options(parse_options);
+    EXPECT_EQ(LEPT_PARSE_IO_ERROR, d.lept_parse_file(path));
+}
+
+void test_parse_events()
+{
+    TEST_EVENTS("null ", " null ");
+    TEST_EVENTS("true ", "true");
+    TEST_EVENTS("false ", "false");
+    TEST_EVENTS("d1.500000 ", "1.5");
+    TEST_EVENTS("i-42 ", "-42");
+    TEST_EVENTS("u18446744073709551615 ", "18446744073709551615");
+    TEST_EVENTS("s:a\nb ", "\"a\\nb\"");
+    TEST_EVENTS("[ ]0 ", "[ ]");
+    TEST_EVENTS("{ }0 ", "{ }");
+    TEST_EVENTS("[ i1 [ s:x ]1 { k:a null }1 ]3 ", "[1, [\"x\"], {\"a\": null}]");
+    TEST_EVENTS("{ k:a [ true false ]2 k:b\\ { k:c i0 }1 }2 ", "{\"a\":[true,false],\"b\\\\\":{\"c\":0}}");
+
+    /* 错误码与构造树时相同，出错前的事件已经发出 */
+    record_handler h;
+    EXPECT_EQ(LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, lept_parse_events("[1 2]", 5, h));
+    EXPECT_EQ(std::string("[ i1 "), h.events);
+    EXPECT_EQ(LEPT_PARSE_MISS_COLON, lept_parse_events("{\"a\" 1}", 7, h));
+    EXPECT_EQ(LEPT_PARSE_ROOT_NOT_SINGULAR, lept_parse_events("null x", 6, h));
+    EXPECT_EQ(LEPT_PARSE_EXPECT_VALUE, lept_parse_events("", 0, h));
+}
+
+void test_document()
+{
+#if 1 // 解析与访问
+    {
+        lept_document d;
+        d.lept_set_options(parse_options);
+        EXPECT_EQ(LEPT_PARSE_OK, d.lept_parse("{ \"a\" : [ 1 , \"abc\" , { } ] , \"b\" : true }"));
+        lept_value v = d.lept_get_root(); // 拷贝出的值持有自己的内容
+        EXPECT_EQ(LEPT_OBJECT, v.lept_get_type());
+        lept_value k;
+        k.lept_set_string("a");
+        lept_value a = v.lept_get_object_value(k);
+        EXPECT_EQ((size_t)3, a.lept_get_array_size());
+        EXPECT_EQ("abc", a.lept_get_array_element(1).lept_get_string());
+        EXPECT_EQ(0, (int)v.flags);
+    }
+#endif
+
+#if 1 // 重复解析复用同一个 arena
+    {
+        lept_document d;
+        d.lept_set_options(parse_options);
+        EXPECT_EQ(LEPT_PARSE_OK, d.lept_parse("[ \"x\" ]"));
+        EXPECT_EQ(LEPT_PARSE_OK, d.lept_parse("\"y\""));
+        EXPECT_EQ(LEPT_STRING, d.lept_get_root().type);
+        EXPECT_EQ(LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, d.lept_parse("[ 1 2 ]"));
+    }
+#endif
+
+#if 1 // arena 按块分配
+    {
+        lept_arena arena(64);
+        for (int i = 0; i < 100; i++)
+            arena.lept_alloc(10);
+        EXPECT_EQ(true, arena.lept_get_block_count() > 1);
+        EXPECT_EQ((size_t)1600, arena.lept_get_used_size()); // 按 8 字节对齐
+        arena.lept_clear();
+        EXPECT_EQ((size_t)1, arena.lept_get_block_count());
+        EXPECT_EQ((size_t)0, arena.lept_get_used_size());
+    }
+#endif
+}
+
+/** 测试文档中对象的键的驻留 */
+void test_intern()
+{
+    std::string json = "[";
+    for (int i = 0; i < 100; i++)
+    {
+        json += i ? ",{" : "{";
+        for (int j = 0; j < 20; j++) // 20 个键，超过建立索引的成员数
+            json += (j ? ",\"field_" : "\"field_") + std::to_string(j) + "\":" + std::to_string(i * 20 + j);
+        json += ",\"sm\\u0061ll\":{\"a\":" + std::to_string(i) + ",\"\":[]}}";
+    }
+    json += "]";
+
+#if 1 // 相同的键共用一份内容
+    {
+        lept_document d;
+        EXPECT_EQ(LEPT_PARSE_OK, d.lept_parse(json));
+        const lept_value &root = d.lept_get_root();
+        const lept_member &m0 = root.lept_array_at(0).lept_get_object_member(20);
+        const lept_member &m1 = root.lept_array_at(99).lept_get_object_member(20);
+        EXPECT_EQ("small", m1.k.lept_get_string());
+        EXPECT_EQ(true, m0.k.u.s == m1.k.u.s);
+        EXPECT_EQ(LEPT_FLAG_BORROWED | LEPT_FLAG_INTERNED, (int)m1.k.flags);
+        EXPECT_EQ(true, m0.v.lept_get_object_member(1).k.u.s == m1.v.lept_get_object_member(1).k.u.s); // 空键
+        EXPECT_EQ(0, (int)m1.v.lept_get_object_member(1).k.size);
+
+        lept_value k = d.lept_get_key("field_7"), s = d.lept_get_key("small"), a = d.lept_get_key("a", 1);
+        EXPECT_EQ(LEPT_FLAG_BORROWED | LEPT_FLAG_INTERNED, (int)k.flags);
+        EXPECT_EQ(LEPT_NULL, d.lept_get_key("field_20").type);
+        EXPECT_EQ(LEPT_NULL, d.lept_get_key("sm").type);
+        EXPECT_EQ(true, root.lept_array_at(0).lept_find_object_value(d.lept_get_key("sm")) == NULL);
+        EXPECT_EQ(LEPT_NULL, root.lept_array_at(0).lept_get_object_value(d.lept_get_key("field_20")).type);
+        int found = 0;
+        for (int i = 0; i < 100; i++)
+        {
+            const lept_value &e = root.lept_array_at(i);
+            found += e.lept_find_object_value(k)->lept_get_number() == i * 20 + 7;
+            found += e.lept_find_object_value(s)->lept_find_object_value(a)->lept_get_number() == i;
+            found += e.lept_find_object_value("field_19")->lept_get_number() == i * 20 + 19;
+        }
+        EXPECT_EQ(300, found);
+
+        lept_value c = root; // 拷贝出的值持有自己的键
+        EXPECT_EQ(0, (int)c.lept_array_at(5).lept_get_object_member(3).k.flags);
+        EXPECT_EQ(0., c.lept_array_at(0).lept_find_object_value(s)->lept_find_object_value(a)->lept_get_number());
+        EXPECT_EQ(27., c.lept_array_at(1).lept_find_object_value(k)->lept_get_number());
+        lept_value other; // 其他文档或普通字符串作为键时按内容比较
+        other.lept_set_string("field_7");
+        EXPECT_EQ(47., root.lept_array_at(2).lept_find_object_value(other)->lept_get_number());
+
+        EXPECT_EQ(LEPT_PARSE_OK, d.lept_parse("{\"b\":1}")); // 重新解析后之前的键不再驻留
+        EXPECT_EQ(LEPT_NULL, d.lept_get_key("field_7").type);
+        EXPECT_EQ(LEPT_STRING, d.lept_get_key("b").type);
+    }
+#endif
+
+#if 1 // 驻留减少了占用，两个引擎与 tape 的结果相同
+    {
+        auto text = [](const lept_document &d) {
+            lept_buffer b;
+            lept_value::lept_stringify(d.lept_get_root(), b);
+            return std::string(b.lept_get_data(), b.lept_get_size());
+        };
+        lept_document d, plain;
+        plain.lept_set_intern_keys(false);
+        EXPECT_EQ(LEPT_PARSE_OK, d.lept_parse(json));
+        EXPECT_EQ(LEPT_PARSE_OK, plain.lept_parse(json));
+        EXPECT_EQ(true, d.lept_get_used_size() < plain.lept_get_used_size());
+        EXPECT_EQ((int)LEPT_FLAG_BORROWED, (int)plain.lept_get_root().lept_array_at(0).lept_get_object_member(0).k.flags);
+        EXPECT_EQ(LEPT_NULL, plain.lept_get_key("small").type);
+        EXPECT_EQ(text(plain), text(d));
+
+        lept_parse_options indexed;
+        indexed.engine = LEPT_ENGINE_INDEXED;
+        lept_document e;
+        e.lept_set_options(indexed);
+        EXPECT_EQ(LEPT_PARSE_OK, e.lept_parse(json));
+        EXPECT_EQ(text(plain), text(e));
+        EXPECT_EQ(d.lept_get_used_size(), e.lept_get_used_size());
+
+        lept_buffer b;
+        lept_value::lept_encode(d.lept_get_root(), b);
+        lept_document t;
+        EXPECT_EQ(LEPT_PARSE_OK, t.lept_decode(b.lept_get_data(), b.lept_get_size()));
+        EXPECT_EQ(text(plain), text(t));
+        EXPECT_EQ(LEPT_FLAG_BORROWED | LEPT_FLAG_INTERNED,
+                  (int)t.lept_get_root().lept_array_at(3).lept_get_object_member(0).k.flags);
+    }
+#endif
+
+#if 1 // 键的顺序变化时猜测落空，结果不变
+    {
+        lept_document d;
+        EXPECT_EQ(LEPT_PARSE_OK, d.lept_parse("[{\"a\":1,\"b\":2},{\"b\":3,\"a\":4},{\"a\":5,\"c\":6,\"b\":7},{\"ab\":8}]"));
+        const lept_value &root = d.lept_get_root();
+        lept_value a = d.lept_get_key("a"), b = d.lept_get_key("b");
+        EXPECT_EQ(true, root.lept_array_at(1).lept_get_object_member(1).k.u.s == a.u.s);
+        EXPECT_EQ(true, root.lept_array_at(2).lept_get_object_member(2).k.u.s == b.u.s);
+        EXPECT_EQ(4., root.lept_array_at(1).lept_find_object_value(a)->lept_get_number());
+        EXPECT_EQ(7., root.lept_array_at(2).lept_find_object_value(b)->lept_get_number());
+        EXPECT_EQ(true, root.lept_array_at(3).lept_find_object_value(a) == NULL);
+        EXPECT_EQ("ab", root.lept_array_at(3).lept_get_object_member(0).k.lept_get_string());
+    }
+#endif
+
+#if 1 // 原地解析的键直接引用输入
+    {
+        lept_document d;
+        std::string copy = json;
+        EXPECT_EQ(LEPT_PARSE_OK, d.lept_parse_insitu(&copy[0], copy.size()));
+        EXPECT_EQ((int)LEPT_FLAG_BORROWED, (int)d.lept_get_root().lept_array_at(0).lept_get_object_member(0).k.flags);
+        EXPECT_EQ(LEPT_NULL, d.lept_get_key("field_0").type);
+    }
+#endif
+}
+
+/** 测试序列化 */
+void test_stream()
+{
+    /* 按各种方式切分输入，结果应当与一次性解析相同 */
+    const char *inputs[] = {
+        "null", " true ", "false", "0", "-0", "123", "-1.5e-10", "1E+300", "18446744073709551615",
+        "\"\"", "\"Hello\\nWorld\"", "\"\\u00A2\\u20AC\\uD834\\uDD1E\"", "\"\\\\\\\"\\/\"",
+        "[ null , false , true , 123 , \"abc\" ]", "[ [ ] , [ 0 ] , [ 0 , 1 ] ]",
+        "{ \"n\" : null , \"a\" : [ 1, 2, 3 ], \"o\" : { \"1\" : 1, \"2\" : 2 } }", "{}", "[]", " [ { } ] ",
+        "", " ", "nul", "?", "nulx", "truex", "0123", "0x0", "1.", ".1", "1e", "INF", "1e309",
+        "\"abc", "\"\\v\"", "\"\\x12\"", "\"\x01\"", "\"\\u12\"", "\"\\uD800\"", "\"\\uD800\\uE000\"",
+        "[1", "[1}", "[1 2", "[1,]", "[\"a\", nul]", "{", "{1:1}", "{\"a\"}", "{\"a\":}", "{\"a\":1",
+        "{\"a\":1]", "{\"a\":1,}", "{\"a\" 1}", "null x", "[1] [2]", "[truex]", "{\"a\":0123}",
+    };
+    lept_buffer expect, actual;
+    int ok = 0, total = 0;
+    for (const char *json : inputs)
+    {
+        size_t len = strlen(json);
+        lept_value v;
+        lept_parse_ret ret = lept_value::lept_parse(v, json);
+        expect.lept_clear();
+        if (ret == LEPT_PARSE_OK)
+            lept_value::lept_stringify(v, expect);
+
+        for (size_t step = 1; step <= len + 1; step++) // 每块 step 字节
+            for (size_t first = 0; first <= len; first += step > 1 ? 1 : len + 1) // 第一块的长度
+            {
+                lept_stream st;
+                lept_parse_ret r = LEPT_PARSE_INCOMPLETE;
+                for (size_t i = 0, n = step > 1 ? first : step; i < len; i += n, n = step) // 空块也应当被接受
+                {
+                    if (n > len - i)
+                        n = len - i;
+                    char *chunk = new char[n + 1]; // 只复制本块，读到块外会被 sanitizer 发现
+                    memcpy(chunk, json + i, n);
+                    r = st.lept_feed(chunk, n);
+                    delete[] chunk;
+                }
+                lept_value w;
+                lept_parse_ret fin = st.lept_finish(w);
+                actual.lept_clear();
+                if (fin == LEPT_PARSE_OK)
+                    lept_value::lept_stringify(w, actual);
+                total++;
+                if (fin == ret && (r == LEPT_PARSE_INCOMPLETE || r == ret) && 0 == strcmp(expect.lept_get_data(), actual.lept_get_data()))
+                    ok++;
+                else
+                    std::cerr << "stream mismatch: " << json << " step " << step << " first " << first << '\n';
+            }
+    }
+    EXPECT_EQ(total, ok);
+
+#if 1 // 状态与复用
+    {
+        lept_stream st;
+        lept_value v;
+        EXPECT_EQ(LEPT_PARSE_INCOMPLETE, st.lept_feed("{\"a\":", 5));
+        EXPECT_EQ(LEPT_PARSE_INCOMPLETE, st.lept_feed("[1,2", 4));
+        EXPECT_EQ(LEPT_PARSE_OK, st.lept_feed("]} ", 3));
+        EXPECT_EQ(LEPT_PARSE_OK, st.lept_feed("\n", 1));
+        EXPECT_EQ(LEPT_PARSE_OK, st.lept_finish(v));
+        EXPECT_EQ((size_t)2, v.lept_find_object_value("a")->lept_get_array_size());
+
+        EXPECT_EQ(LEPT_PARSE_INCOMPLETE, st.lept_feed("12", 2)); // 数字要等到输入结束才能确定
+        EXPECT_EQ(LEPT_PARSE_INCOMPLETE, st.lept_feed("34", 2));
+        EXPECT_EQ(LEPT_PARSE_OK, st.lept_finish(v));
+        EXPECT_EQ(1234.0, v.lept_get_number());
+
+        EXPECT_EQ(LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, st.lept_feed("[1 2", 4));
+        EXPECT_EQ(LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, st.lept_feed("]", 1));
+        EXPECT_EQ(LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, st.lept_finish(v));
+        EXPECT_EQ(LEPT_PARSE_OK, st.lept_feed("[]", 2));
+        EXPECT_EQ(LEPT_PARSE_OK, st.lept_finish(v));
+        EXPECT_EQ(LEPT_ARRAY, v.lept_get_type());
+    }
+#endif
+
+#if 1 // 深层嵌套不使用递归
+    {
+        lept_parse_options options;
+        options.max_depth = 10000;
+        lept_stream st(options);
+        lept_value v;
+        for (int i = 0; i < 10000; i++)
+            st.lept_feed("[", 1);
+        for (int i = 0; i < 10000; i++)
+            st.lept_feed("]", 1);
+        EXPECT_EQ(LEPT_PARSE_OK, st.lept_finish(v));
+        EXPECT_EQ((size_t)1, v.lept_get_array_size());
+    }
+#endif
+}
+
+void test_stringify()
+{
+#if 1 // 字面量与数字
+    TEST_ROUNDTRIP("null");
+    TEST_ROUNDTRIP("false");
+    TEST_ROUNDTRIP("true");
+    TEST_ROUNDTRIP("0");
+    TEST_ROUNDTRIP("-0.0");
+    TEST_ROUNDTRIP("1.0");
+    TEST_ROUNDTRIP("-1.5");
+    TEST_ROUNDTRIP("3.25");
+    TEST_ROUNDTRIP("0.1");
+    TEST_ROUNDTRIP("1e-7");
+    TEST_ROUNDTRIP("1.234e25");
+    TEST_ROUNDTRIP("123400000000000000000.0");
+    TEST_ROUNDTRIP("1e30");
+    TEST_ROUNDTRIP("5e-324");
+    TEST_ROUNDTRIP("1.7976931348623157e308");
+    TEST_ROUNDTRIP("9223372036854775807");
+    TEST_ROUNDTRIP("-9223372036854775808");
+    TEST_ROUNDTRIP("18446744073709551615");
+#endif
+
+#if 1 // 字符串
+    TEST_ROUNDTRIP("\"\"");
+    TEST_ROUNDTRIP("\"Hello\"");
+    TEST_ROUNDTRIP("\"Hello\\nWorld\"");
+    TEST_ROUNDTRIP("\"\\\" \\\\ / \\b \\f \\n \\r \\t\"");
+    TEST_ROUNDTRIP("\"Hello\\u0000World\\u001F\"");
+    TEST_ROUNDTRIP("\"\xE4\xB8\xAD\xE6\x96\x87\"");
+#endif
+
+#if 1 // 数组与对象
+    TEST_ROUNDTRIP("[]");
+    TEST_ROUNDTRIP("[null,false,true,123,\"abc\",[1,2,3]]");
+    TEST_ROUNDTRIP("{}");
+    TEST_ROUNDTRIP("{\"n\":null,\"f\":false,\"t\":true,\"i\":123,\"s\":\"abc\",\"a\":[1,2,3],\"o\":{\"1\":1,\"2\":2}}");
+#endif
+
+#if 1 // 缩进格式
+    {
+        lept_value v;
+        lept_buffer b;
+        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, "{\"a\":[1,{}],\"b\":[]}", parse_options));
+        lept_value::lept_stringify(v, b, LEPT_STRINGIFY_PRETTY);
+        EXPECT_EQ("{\n    \"a\": [\n        1,\n        {}\n    ],\n    \"b\": []\n}", b.lept_get_data());
+    }
+#endif
+
+#if 1 // 缓冲复用，内容追加在末尾
+    {
+        lept_value v;
+        lept_buffer b;
+        v.lept_set_string("x");
+        lept_value::lept_stringify(v, b);
+        lept_value::lept_stringify(v, b);
+        EXPECT_EQ("\"x\"\"x\"", b.lept_get_data());
+        b.lept_clear();
+        EXPECT_EQ((size_t)0, b.lept_get_size());
+        v.lept_set_number(1.5);
+        lept_value::lept_stringify(v, b);
+        EXPECT_EQ("1.5", b.lept_get_data());
+    }
+#endif
+
+#if 1 // 任意 double 都能精确地解析回来
+    {
+        uint64_t bits = 0x123456789ABCDEFull;
+        int exact = 0;
+        lept_buffer b;
+        for (int i = 0; i < 10000; i++)
+        {
+            bits = bits * 6364136223846793005ull + 1442695040888963407ull;
+            double d;
+            memcpy(&d, &bits, sizeof(d));
+            if (std::isnan(d) || std::isinf(d))
+                d = i;
+            lept_value v, r;
+            v.lept_set_number(d);
+            b.lept_clear();
+            lept_value::lept_stringify(v, b);
+            if (lept_value::lept_parse(r, b.lept_get_data(), parse_options) == LEPT_PARSE_OK &&
+                r.lept_get_number() == d)
+                exact++;
+        }
+        EXPECT_EQ(10000, exact);
+    }
+#endif
 }
 
 /************************************************************************************** */
 
+/** 以指定引擎解析并序列化，失败时只返回错误码 */
+std::string parse_with(lept_engine engine, const std::string &json)
+{
+    lept_parse_options options;
+    options.engine = engine;
+    lept_value v;
+    lept_parse_ret ret = lept_value::lept_parse(v, json, options);
+    std::string result = std::to_string(ret);
+    if (ret == LEPT_PARSE_OK)
+    {
+        lept_buffer b;
+        lept_value::lept_stringify(v, b);
+        result += b.lept_get_data();
+    }
+    return result;
+}
+
+void test_engine()
+{
+    /* 结构索引引擎在每个 SIMD 级别下都要通过全部解析测试 */
+    lept_simd_level max = lept_get_simd_level();
+    for (int level = LEPT_SIMD_NONE; level <= max; level++)
+    {
+        lept_set_simd_level((lept_simd_level)level);
+        parse_options.engine = LEPT_ENGINE_INDEXED;
+        test_parse_null();
+        test_parse_true();
+        test_parse_false();
+        test_parse_error_value();
+        test_parse_number();
+        test_parse_integer();
+        test_parse_string();
+        test_parse_length();
+        test_parse_array();
+        test_parse_object();
+        test_parse_nested();
+        test_access();
+        test_object_index();
+        test_document();
+        test_parse_file();
+        test_parse_insitu();
+        test_stringify();
+    }
+    lept_set_simd_level(max);
+    parse_options.engine = LEPT_ENGINE_DESCENT;
+
+    /* 文档在各次解析间复用上下文与索引：输入忽长忽短、中途出错，结果都与单独解析相同 */
+    {
+        lept_parse_options indexed;
+        indexed.engine = LEPT_ENGINE_INDEXED;
+        lept_document d;
+        d.lept_set_options(indexed);
+        std::string inputs[] = {
+            "[" + std::string(200, ' ') + "{\"k\" : \"" + std::string(100, 'v') + "\"}, [1, 2, 3], \"\\n\"]",
+            "[1, 2",
+            "{\"a\":\"b\"}",
+            "  \"x\"  ",
+            "[1 2]",
+            "[]",
+        };
+        int same = 0;
+        for (const std::string &json : inputs)
+        {
+            lept_parse_ret ret = d.lept_parse(json);
+            std::string result = std::to_string(ret);
+            if (ret == LEPT_PARSE_OK)
+            {
+                lept_buffer b;
+                lept_value::lept_stringify(d.lept_get_root(), b);
+                result += b.lept_get_data();
+            }
+            same += result == parse_with(LEPT_ENGINE_DESCENT, json);
+        }
+        EXPECT_EQ(6, same);
+    }
+
+    /* 随机改动合法的文本，两个引擎的结果应当相同；长字符串与反斜杠用来跨越 64 字节的块边界 */
+    std::string samples[] = {
+        "{ \"a\" : [ 1, -2.5e3, true, false, null ], \"b\" : { \"c\" : \"d\\\"e\\\\\" }, \"e\" : [] }",
+        "[\"" + std::string(60, 'x') + "\\\\\\\"\", \"" + std::string(63, '\\') + "\\\"\", [[[{}]]], 0, \"\\u00e9\"]",
+        "  [ 123456789012345678901234567890 , \"tab\\tnl\\n\" , {\"k\":{\"k\":{\"k\":[true]}}} ]  ",
+    };
+    const char noise[] = "\"\\[]{}:, \t\n1e-.tnx\x01\x80";
+    uint32_t seed = 12345;
+    auto rnd = [&](uint32_t n) {
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 8) % n;
+    };
+    int ok = 0, total = 0;
+    for (const std::string &sample : samples)
+        for (int round = 0; round < 3000; round++)
+        {
+            std::string json = sample;
+            for (int k = (int)rnd(3) + 1; k > 0 && !json.empty(); k--)
+            {
+                size_t pos = rnd((uint32_t)json.size());
+                switch (rnd(3))
+                {
+                case 0:
+                    json.erase(pos, 1);
+                    break;
+                case 1:
+                    json.insert(pos, 1, noise[rnd(sizeof(noise) - 1)]);
+                    break;
+                default:
+                    json[pos] = noise[rnd(sizeof(noise) - 1)];
+                }
+            }
+            total++;
+            std::string expect = parse_with(LEPT_ENGINE_DESCENT, json);
+            if (expect == parse_with(LEPT_ENGINE_INDEXED, json))
+                ok++;
+            else
+                std::cerr << "engine mismatch: " << json << '\n';
+        }
+    EXPECT_EQ(total, ok);
+}
+
+void test_batch()
+{
+#if 1 // 切分与逐行的结果
+    const char *json = "{\"a\":1}\n\n  [1,2]\r\n\t \n\"x\\ny\"\n{\"a\":}\ntrue";
+    lept_batch batch(2);
+    EXPECT_EQ(2u, batch.lept_get_threads());
+    EXPECT_EQ((size_t)5, batch.lept_parse_lines(json, strlen(json)));
+    EXPECT_EQ((size_t)5, batch.lept_get_size());
+    EXPECT_EQ(LEPT_PARSE_OK, batch.lept_get_error(0));
+    EXPECT_EQ((int64_t)1, batch.lept_get_value(0).lept_find_object_value("a")->lept_get_int64());
+    EXPECT_EQ((size_t)9, batch.lept_get_offset(1));
+    EXPECT_EQ((size_t)2, batch.lept_get_value(1).lept_get_array_size());
+    EXPECT_EQ("x\ny", batch.lept_get_value(2).lept_get_string());
+    EXPECT_EQ(LEPT_PARSE_INVALID_VALUE, batch.lept_get_error(3));
+    EXPECT_EQ(LEPT_NULL, batch.lept_get_value(3).lept_get_type());
+    EXPECT_EQ(LEPT_TRUE, batch.lept_get_value(4).lept_get_type());
+
+    EXPECT_EQ((size_t)0, batch.lept_parse_lines(std::string(" \n\n")));
+    EXPECT_EQ((size_t)0, batch.lept_parse_lines("", 0));
+#endif
+
+#if 1 // 线程数不影响结果
+    std::string lines;
+    for (int i = 0; i < 1000; i++)
+        lines += i % 97 == 0 ? "[1,]\n" : "{\"id\":" + std::to_string(i) + ",\"s\":\"" + std::string(i % 50, 'x') + "\"}\n";
+    for (unsigned threads : {1u, 3u, 8u})
+    {
+        batch.lept_set_threads(threads);
+        EXPECT_EQ((size_t)1000, batch.lept_parse_lines(lines));
+        int ok = 0;
+        for (size_t i = 0; i < batch.lept_get_size(); i++)
+        {
+            size_t offset = batch.lept_get_offset(i);
+            lept_value v;
+            lept_parse_ret ret = lept_value::lept_parse(v, lines.substr(offset, lines.find('\n', offset) - offset));
+            lept_buffer expect, actual;
+            lept_value::lept_stringify(v, expect);
+            lept_value::lept_stringify(batch.lept_get_value(i), actual);
+            if (ret == batch.lept_get_error(i) && strcmp(expect.lept_get_data(), actual.lept_get_data()) == 0)
+                ok++;
+        }
+        EXPECT_EQ(1000, ok);
+    }
+#endif
+}
+
+/** 解析结果的文本形式：错误码，成功时后接序列化的结果 */
+std::string parse_result(lept_parse_ret ret, const lept_value &v)
+{
+    std::string result = std::to_string(ret);
+    if (ret == LEPT_PARSE_OK)
+    {
+        lept_buffer b;
+        lept_value::lept_stringify(v, b);
+        result += b.lept_get_data();
+    }
+    return result;
+}
+
+void test_parse_parallel()
+{
+    /* 字符串中的括号、逗号、引号与成串的反斜杠散布在各处，会跨越分段的边界 */
+    uint32_t seed = 54321;
+    auto rnd = [&](uint32_t n) {
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 8) % n;
+    };
+    static const char *pieces[] = {"]", ",", "[", "{", "\\\"", "\\\\", "\\\\\\\\\\\\", "x", "\\u00e9", " "};
+    std::string json = " [ ";
+    for (int i = 0; i < 3000; i++)
+    {
+        if (i)
+            json += rnd(2) ? "," : " ,\n";
+        switch (rnd(4))
+        {
+        case 0:
+            json += std::to_string((int)rnd(100000) - 50000);
+            break;
+        case 1:
+            json += "{\"k\":[1,{\"a\":\"]\"}],\"e\":[]}";
+            break;
+        default:
+            json += '"';
+            for (int k = (int)rnd(12); k > 0; k--)
+                json += pieces[rnd(sizeof(pieces) / sizeof(pieces[0]))];
+            json += '"';
+        }
+    }
+    json += " ] \n";
+
+    lept_value expect, actual;
+    std::string result = parse_result(lept_value::lept_parse(expect, json), expect);
+    EXPECT_EQ((size_t)3000, expect.lept_get_array_size());
+    for (unsigned threads : {1u, 2u, 3u, 8u, 0u})
+        EXPECT_EQ(result, parse_result(lept_value::lept_parse_parallel(actual, json.data(), json.size(), threads), actual));
+
+    /* 文档各线程从自己的 arena 分配，反复解析时复用 */
+    lept_document d;
+    for (unsigned threads : {4u, 2u, 8u})
+    {
+        EXPECT_EQ(result, parse_result(d.lept_parse_parallel(json, threads), d.lept_get_root()));
+        EXPECT_EQ(true, d.lept_get_used_size() > json.size());
+    }
+
+    /* 几个线程同时并行解析：线程池一次只执行一个任务，其余调用改用临时线程，结果不受影响 */
+    {
+        int same[3] = {0, 0, 0};
+        std::vector<std::thread> callers;
+        for (int t = 0; t < 3; t++)
+            callers.emplace_back([&, t] {
+                lept_document doc;
+                lept_value v;
+                for (int round = 0; round < 5; round++)
+                {
+                    same[t] += result == parse_result(doc.lept_parse_parallel(json, 3), doc.lept_get_root());
+                    same[t] += result == parse_result(lept_value::lept_parse_parallel(v, json.data(), json.size(), 3), v);
+                }
+            });
+        for (std::thread &t : callers)
+            t.join();
+        EXPECT_EQ(30, same[0] + same[1] + same[2]);
+    }
+
+    /* 错误与非数组的根：结果与顺序解析相同，多处错误时取位置最靠前的一处 */
+    std::string samples[] = {
+        "[]",
+        " [ 1 ] ",
+        "{\"a\":[1,2]}",
+        "[1,2] 3",
+        "[1,2]]",
+        "[1,2}",
+        "[1,2",
+        "[" + std::string(9000, ' ') + "1,]",
+        json.substr(0, json.size() - 4),
+        json.substr(0, 20000) + "?" + json.substr(20000, 10000) + "!" + json.substr(30000),
+        json.substr(0, 20000) + "\"" + json.substr(20000),
+    };
+    for (const std::string &sample : samples)
+    {
+        std::string expect_result = parse_result(lept_value::lept_parse(expect, sample), expect);
+        EXPECT_EQ(expect_result, parse_result(lept_value::lept_parse_parallel(actual, sample.data(), sample.size(), 4), actual));
+        EXPECT_EQ(expect_result, parse_result(d.lept_parse_parallel(sample, 4), d.lept_get_root()));
+    }
+
+    /* 随机改动，分段多时每段的扫描都可能出错 */
+    const char noise[] = "\"\\[]{}:, 1x";
+    int ok = 0;
+    for (int round = 0; round < 200; round++)
+    {
+        std::string mutated = json;
+        for (int k = (int)rnd(3) + 1; k > 0; k--)
+            mutated[rnd((uint32_t)mutated.size())] = noise[rnd(sizeof(noise) - 1)];
+        std::string expect_result = parse_result(lept_value::lept_parse(expect, mutated), expect);
+        if (expect_result == parse_result(lept_value::lept_parse_parallel(actual, mutated.data(), mutated.size(), 4), actual))
+            ok++;
+    }
+    EXPECT_EQ(200, ok);
+}
+
+void test_stats()
+{
+    const char *json = " [null,true,false,1.5,\"a\\tb\",{\"k\":[[]]}] ";
+    lept_parse_stats stats;
+    lept_value v;
+    lept_set_parse_stats(&stats);
+    EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, json));
+    lept_set_parse_stats(NULL);
+    EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, "[1]")); // 不再记录
+#ifdef LEPT_STATS
+    EXPECT_EQ(true, lept_stats_enabled());
+    EXPECT_EQ((uint64_t)1, stats.documents);
+    EXPECT_EQ((uint64_t)strlen(json), stats.bytes);
+    EXPECT_EQ((uint64_t)1, stats.nodes[LEPT_NULL]);
+    EXPECT_EQ((uint64_t)1, stats.nodes[LEPT_TRUE]);
+    EXPECT_EQ((uint64_t)1, stats.nodes[LEPT_FALSE]);
+    EXPECT_EQ((uint64_t)1, stats.nodes[LEPT_NUMBER]);
+    EXPECT_EQ((uint64_t)1, stats.nodes[LEPT_STRING]);
+    EXPECT_EQ((uint64_t)3, stats.nodes[LEPT_ARRAY]);
+    EXPECT_EQ((uint64_t)1, stats.nodes[LEPT_OBJECT]);
+    EXPECT_EQ((uint64_t)4, stats.string_bytes);
+    EXPECT_EQ((uint64_t)1, stats.escapes);
+    EXPECT_EQ((uint64_t)4, stats.max_depth);
+    EXPECT_EQ((uint64_t)5, stats.allocs); // 字符串、键、外层数组、对象成员与 [[]]，空数组不分配
+    EXPECT_EQ(true, stats.total_ns >= stats.string_ns + stats.number_ns);
+    EXPECT_EQ(stats.total_ns - stats.string_ns - stats.number_ns, stats.lept_get_container_ns());
+
+    /* 文档从 arena 分配，出错的解析也计入 */
+    lept_parse_stats doc_stats;
+    lept_document d;
+    lept_set_parse_stats(&doc_stats);
+    EXPECT_EQ(LEPT_PARSE_OK, d.lept_parse(json));
+    EXPECT_EQ(LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, d.lept_parse("[[1] 2]"));
+    lept_set_parse_stats(NULL);
+    EXPECT_EQ((uint64_t)2, doc_stats.documents);
+    EXPECT_EQ((uint64_t)1, doc_stats.allocs);
+    EXPECT_EQ((uint64_t)4, doc_stats.max_depth);
+
+    stats.lept_add(doc_stats);
+    EXPECT_EQ((uint64_t)3, stats.documents);
+    EXPECT_EQ((uint64_t)4, stats.max_depth);
+    EXPECT_EQ((uint64_t)2, stats.nodes[LEPT_STRING]);
+#else
+    EXPECT_EQ(false, lept_stats_enabled());
+    EXPECT_EQ((uint64_t)0, stats.documents);
+    EXPECT_EQ((uint64_t)0, stats.total_ns);
+#endif
+}
+
+void test_tape()
+{
+    const char *json = "{\"id\":12345678901234,\"big\":18446744073709551615,\"neg\":-7,\"pi\":3.25,\"ok\":true,"
+                       "\"no\":false,\"nil\":null,\"s\":\"a\\u0000b\\n\",\"empty\":{},\"list\":[[],\"x\",{\"k\":1}],"
+                       "\"id\":2}";
+    lept_value v;
+    EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, json));
+    lept_buffer tape;
+    lept_value::lept_encode(v, tape);
+    std::string data(tape.lept_get_data(), tape.lept_get_size());
+
+#if 1 // 还原出的树与原来的相同
+    lept_buffer expect, actual;
+    lept_value::lept_stringify(v, expect);
+    lept_value u;
+    EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_decode(u, data.data(), data.size()));
+    lept_value::lept_stringify(u, actual);
+    EXPECT_EQ(expect.lept_get_data(), actual.lept_get_data());
+    EXPECT_EQ(true, u.lept_find_object_value("id")->lept_is_int64());
+    EXPECT_EQ(false, u.lept_find_object_value("big")->lept_is_int64());
+    EXPECT_EQ(true, u.lept_find_object_value("big")->lept_is_uint64());
+
+    lept_document d;
+    EXPECT_EQ(LEPT_PARSE_OK, d.lept_decode(data.data(), data.size()));
+    actual.lept_clear();
+    lept_value::lept_stringify(d.lept_get_root(), actual);
+    EXPECT_EQ(expect.lept_get_data(), actual.lept_get_data());
+#endif
+
+#if 1 // 直接访问 tape
+    lept_tape_value root = lept_tape_value::lept_open(data.data(), data.size());
+    EXPECT_EQ(true, root.lept_is_valid());
+    EXPECT_EQ(LEPT_OBJECT, root.lept_get_type());
+    EXPECT_EQ((size_t)11, root.lept_get_object_size());
+    EXPECT_EQ((int64_t)12345678901234, root.lept_find_object_value("id").lept_get_int64()); // 重复的键取第一个
+    EXPECT_EQ(UINT64_MAX, root.lept_find_object_value("big").lept_get_uint64());
+    EXPECT_EQ(-7.0, root.lept_find_object_value("neg").lept_get_number());
+    EXPECT_EQ(false, root.lept_find_object_value("neg").lept_is_uint64());
+    EXPECT_EQ(3.25, root.lept_find_object_value("pi").lept_get_number());
+    EXPECT_EQ(true, root.lept_find_object_value("ok").lept_get_boolean());
+    EXPECT_EQ(false, root.lept_find_object_value("no").lept_get_boolean());
+    EXPECT_EQ(LEPT_NULL, root.lept_find_object_value("nil").lept_get_type());
+    EXPECT_EQ(true, root.lept_find_object_value("nil").lept_is_valid());
+    lept_tape_value s = root.lept_find_object_value("s");
+    EXPECT_EQ((size_t)4, s.lept_get_string_length());
+    EXPECT_EQ(0, memcmp(s.lept_get_string(), "a\0b\n", 5));
+    EXPECT_EQ(true, s.lept_get_string() > data.data() && s.lept_get_string() < data.data() + data.size());
+    EXPECT_EQ(false, root.lept_find_object_value("missing").lept_is_valid());
+    EXPECT_EQ(false, root.lept_find_object_value("empty").lept_get_first().lept_is_valid());
+
+    lept_tape_value list = root.lept_find_object_value("list");
+    EXPECT_EQ((size_t)3, list.lept_get_array_size());
+    EXPECT_EQ((size_t)0, list.lept_array_at(0).lept_get_array_size());
+    EXPECT_EQ("x", list.lept_array_at(1).lept_get_string());
+    EXPECT_EQ((int64_t)1, list.lept_array_at(2).lept_find_object_value("k").lept_get_int64());
+    EXPECT_EQ(false, list.lept_array_at(3).lept_is_valid());
+    EXPECT_EQ(false, list.lept_find_object_value("k").lept_is_valid()); // 类型不符
+    EXPECT_EQ(false, root.lept_array_at(0).lept_is_valid());
+    EXPECT_EQ(true, list.lept_array_at(1).lept_get_key() == NULL); // 不是对象的成员
+
+    std::string keys;
+    for (lept_tape_value m = root.lept_get_first(); m.lept_is_valid(); m = m.lept_get_next())
+        keys += std::string(m.lept_get_key(), m.lept_get_key_length()) + ' ';
+    EXPECT_EQ(std::string("id big neg pi ok no nil s empty list id "), keys);
+
+    lept_value e;
+    EXPECT_EQ(LEPT_PARSE_OK, list.lept_array_at(2).lept_get_value(e));
+    EXPECT_EQ((int64_t)1, e.lept_find_object_value("k")->lept_get_int64());
+    EXPECT_EQ(LEPT_PARSE_INVALID_VALUE, list.lept_array_at(3).lept_get_value(e));
+#endif
+
+#if 1 // 损坏的 tape
+    for (size_t n = 0; n < data.size(); n++) // 每一种截断都能发现，也不会越界读取
+    {
+        std::vector<char> cut(data.begin(), data.begin() + n);
+        EXPECT_EQ(LEPT_PARSE_INVALID_VALUE, lept_value::lept_decode(u, cut.data(), n));
+        EXPECT_EQ(false, lept_tape_value::lept_open(cut.data(), n).lept_is_valid());
+    }
+    std::string bad = data + ' ';
+    EXPECT_EQ(LEPT_PARSE_INVALID_VALUE, lept_value::lept_decode(u, bad.data(), bad.size()));
+    EXPECT_EQ(false, lept_tape_value::lept_open(bad.data(), bad.size()).lept_is_valid());
+    bad = data;
+    bad[0] = 'X';
+    EXPECT_EQ(LEPT_PARSE_INVALID_VALUE, lept_value::lept_decode(u, bad.data(), bad.size()));
+    bad = data;
+    bad[9]++; // 根对象的成员个数与内容不符
+    EXPECT_EQ(LEPT_PARSE_INVALID_VALUE, lept_value::lept_decode(u, bad.data(), bad.size()));
+    EXPECT_EQ(LEPT_PARSE_INVALID_VALUE, lept_value::lept_decode(u, json, strlen(json)));
+
+    lept_parse_options options;
+    options.max_depth = 2;
+    EXPECT_EQ(LEPT_PARSE_TOO_DEEP, lept_value::lept_decode(u, data.data(), data.size(), options));
+    lept_document doc;
+    doc.lept_set_options(options);
+    EXPECT_EQ(LEPT_PARSE_TOO_DEEP, doc.lept_decode(data.data(), data.size()));
+    options.max_depth = 3;
+    doc.lept_set_options(options);
+    EXPECT_EQ(LEPT_PARSE_OK, doc.lept_decode(data.data(), data.size()));
+#endif
+
+#if 1 // 映射 tape 文件
+    const char *path = "test_tape.bin";
+    FILE *f = fopen(path, "wb");
+    fwrite(data.data(), 1, data.size(), f);
+    fclose(f);
+    lept_tape_file file;
+    EXPECT_EQ(LEPT_PARSE_OK, file.lept_open(path));
+    EXPECT_EQ("x", file.lept_get_root().lept_find_object_value("list").lept_array_at(1).lept_get_string());
+
+    f = fopen(path, "wb");
+    fputs(json, f);
+    fclose(f);
+    EXPECT_EQ(LEPT_PARSE_INVALID_VALUE, file.lept_open(path));
+    EXPECT_EQ(false, file.lept_get_root().lept_is_valid());
+    remove(path);
+    EXPECT_EQ(LEPT_PARSE_IO_ERROR, file.lept_open(path));
+#endif
+}
+
+void test_pointer()
+{
+#if 1 // RFC 6901 的示例
+    const char *json = "{\"foo\":[\"bar\",\"baz\"],\"\":0,\"a/b\":1,\"c%d\":2,\"e^f\":3,\"g|h\":4,\"i\\\\j\":5,"
+                       "\"k\\\"l\":6,\" \":7,\"m~n\":8}";
+    lept_value v;
+    EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, json));
+    EXPECT_EQ(true, v.lept_find_pointer("") == &v);
+    EXPECT_EQ((size_t)2, v.lept_find_pointer("/foo")->lept_get_array_size());
+    EXPECT_EQ("bar", v.lept_find_pointer("/foo/0")->lept_get_string());
+    static const char *pointers[] = {"/", "/a~1b", "/c%d", "/e^f", "/g|h", "/i\\j", "/k\"l", "/ ", "/m~0n"};
+    for (int i = 0; i < 9; i++)
+        EXPECT_EQ((double)i, v.lept_find_pointer(pointers[i])->lept_get_number());
+#endif
+
+#if 1 // 不存在或不合法
+    static const char *missing[] = {"foo", "/foo/2", "/foo/-", "/foo/01", "/foo/+1", "/foo/0/x", "/m~2n", "/m~",
+                                    "/x", "/foo/99999999999999999999"};
+    for (const char *p : missing)
+        EXPECT_EQ(true, v.lept_find_pointer(p) == NULL);
+    EXPECT_EQ("bar", v.lept_find_pointer("/foo/0/x", 6)->lept_get_string()); // 只看前 len 个字符
+#endif
+}
+
+void test_path()
+{
+    const char *json = "{\"user\":{\"id\":7,\"a/b\":\"s\"},\"items\":[{\"price\":1},{\"name\":\"x\"},{\"price\":3,"
+                       "\"price\":4}],\"map\":{\"p\":{\"price\":5},\"q\":[]},\"*\":9}";
+    lept_value v;
+    EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, json));
+    lept_path path;
+
+#if 1 // 在树上求值
+    EXPECT_EQ(true, path.lept_compile("/user/id"));
+    EXPECT_EQ(7.0, path.lept_find(v)->lept_get_number());
+    EXPECT_EQ(true, path.lept_compile("/items/*/price"));
+    const lept_value *out[4];
+    EXPECT_EQ((size_t)2, path.lept_find_all(v, out, 4));
+    EXPECT_EQ(1.0, out[0]->lept_get_number());
+    EXPECT_EQ(3.0, out[1]->lept_get_number());
+    EXPECT_EQ((size_t)2, path.lept_find_all(v, out, 1)); // 只写入 1 个，仍返回总数
+    EXPECT_EQ(1.0, path.lept_find(v)->lept_get_number());
+    EXPECT_EQ(true, path.lept_compile("/*/price"));
+    EXPECT_EQ((size_t)0, path.lept_find_all(v, out, 4));
+    EXPECT_EQ(true, path.lept_compile("/map/*/price"));
+    EXPECT_EQ(5.0, path.lept_find(v)->lept_get_number());
+    EXPECT_EQ(true, path.lept_compile("/*"));
+    EXPECT_EQ((size_t)4, path.lept_find_all(v, out, 4));
+    EXPECT_EQ(true, path.lept_compile(""));
+    EXPECT_EQ(true, path.lept_find(v) == &v);
+    EXPECT_EQ(false, path.lept_compile("/user/~x"));
+    EXPECT_EQ(true, path.lept_find(v) == NULL);
+    EXPECT_EQ(false, path.lept_compile("user"));
+    EXPECT_EQ((size_t)0, path.lept_find_all(v, out, 4));
+#endif
+
+#if 1 // 在文本上求值，结果与在树上相同
+    static const char *paths[] = {"",        "/user",    "/user/id",    "/user/a~1b",   "/items/*/price",
+                                  "/items/1", "/items/3", "/items/-",    "/map/*/price", "/map/*",
+                                  "/*",       "/*/*",     "/~2",         "/user/id/x",   "/items/*/*"};
+    for (const char *p : paths)
+    {
+        lept_path compiled;
+        compiled.lept_compile(p);
+        const lept_value *tree[8];
+        lept_lazy_value raw[8];
+        size_t count;
+        size_t n = compiled.lept_find_all(v, tree, 8);
+        EXPECT_EQ(LEPT_PARSE_OK, compiled.lept_find_all(json, strlen(json), raw, 8, count));
+        EXPECT_EQ(n, count);
+        for (size_t i = 0; i < n && i < count; i++)
+        {
+            lept_value e;
+            EXPECT_EQ(LEPT_PARSE_OK, raw[i].lept_get_value(e));
+            lept_buffer expect, actual;
+            lept_value::lept_stringify(*tree[i], expect);
+            lept_value::lept_stringify(e, actual);
+            EXPECT_EQ(expect.lept_get_data(), actual.lept_get_data());
+        }
+        EXPECT_EQ(n != 0, compiled.lept_find(json, strlen(json)).lept_is_valid());
+    }
+
+    path.lept_compile("/a~1b");
+    EXPECT_EQ(LEPT_STRING, path.lept_find("{\"x\":[1,{}],\"a\\/b\":\"y\"}", 24).lept_get_type()); // 键含转义
+#endif
+
+#if 1 // 通配段之后还有按键或下标下降的段，下降后须从所在容器的末尾继续扫描
+    static const char *cases[][2] = {
+        {"[[{\"y\":1},5],[{\"x\":2}]]", "/*/0/x"},
+        {"[[{\"x\":1},5],[{\"x\":2},{\"x\":3}]]", "/*/0/x"},
+        {"[{\"a\":{\"c\":1},\"z\":2},{\"a\":{\"b\":3}}]", "/*/a/b"},
+        {"[{\"a\":{\"b\":1},\"z\":[2]},{\"a\":{\"b\":3},\"a\":{\"b\":4}}]", "/*/a/b"},
+        {"{\"p\":{\"a\":[1,[2]],\"b\":0},\"q\":{\"a\":5},\"r\":{\"a\":[6,7]}}", "/*/a/1"},
+        {"[[[1,2],[3]],[[4],[5,6]]]", "/*/1/0"},
+        {"[{\"a\":[{\"b\":1},{\"b\":2}]},{\"a\":[{\"b\":3}]}]", "/*/a/*/b"},
+        {"[[{\"a\":{\"b\":[1]}}],[{\"a\":{\"b\":[2]},\"c\":{}}]]", "/*/0/a/b/0"},
+    };
+    for (auto &t : cases)
+    {
+        lept_value tv;
+        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(tv, t[0]));
+        path.lept_compile(t[1]);
+        const lept_value *tree[8];
+        lept_lazy_value raw[8];
+        size_t count, n = path.lept_find_all(tv, tree, 8);
+        EXPECT_EQ(LEPT_PARSE_OK, path.lept_find_all(t[0], strlen(t[0]), raw, 8, count));
+        EXPECT_EQ(true, n > 0);
+        EXPECT_EQ(n, count);
+        for (size_t i = 0; i < n && i < count; i++)
+        {
+            lept_value e;
+            EXPECT_EQ(LEPT_PARSE_OK, raw[i].lept_get_value(e));
+            lept_buffer expect, actual;
+            lept_value::lept_stringify(*tree[i], expect);
+            lept_value::lept_stringify(e, actual);
+            EXPECT_EQ(expect.lept_get_data(), actual.lept_get_data());
+        }
+    }
+#endif
+
+#if 1 // 只扫描到所需的位置为止
+    const char *bad = "{\"a\":1,\"b\":[1,}";
+    size_t len = strlen(bad), count;
+    lept_lazy_value found[2];
+    path.lept_compile("/a");
+    EXPECT_EQ(LEPT_NUMBER, path.lept_find(bad, len).lept_get_type());
+    path.lept_compile("/b/5");
+    EXPECT_EQ(LEPT_PARSE_INVALID_VALUE, path.lept_find(bad, len).lept_get_error());
+    EXPECT_EQ(false, path.lept_find(bad, len).lept_is_valid());
+    path.lept_compile("/c");
+    EXPECT_EQ(LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET, path.lept_find(bad, len).lept_get_error());
+    path.lept_compile("/*");
+    EXPECT_EQ(LEPT_PARSE_MISS_COMMA_OR_CURLY_BRACKET, path.lept_find_all(bad, len, found, 2, count));
+    EXPECT_EQ((size_t)2, count);
+    EXPECT_EQ(LEPT_PARSE_EXPECT_VALUE, path.lept_find(" ", 1).lept_get_error());
+    path.lept_compile("/*/a");
+    EXPECT_EQ(LEPT_NUMBER, path.lept_find("[{\"a\":1,\"b\":[}},x]", 18).lept_get_type()); // 第一个结果之后不再扫描
+    EXPECT_EQ(true, path.lept_find_all("[{\"a\":[1,2", 10, found, 2, count) != LEPT_PARSE_OK);
+    EXPECT_EQ((size_t)1, count); // 匹配的值之后还要继续扫描时，须能找到它的末尾
+#endif
+}
+
+struct bind_pos
+{
+    int x = 0;
+    int y = 0;
+};
+
+struct bind_record
+{
+    int64_t id = -1;
+    std::string name;
+    double score = 0;
+    bool active = false;
+    std::vector<std::string> tags;
+    bind_pos pos;
+    std::vector<bind_pos> path;
+    unsigned char level = 0;
+    float ratio = 0;
+    std::vector<bool> flags;
+};
+
+LEPT_BIND_BEGIN(bind_pos)
+    LEPT_BIND_FIELD(x)
+    LEPT_BIND_FIELD(y)
+LEPT_BIND_END()
+
+LEPT_BIND_BEGIN(bind_record)
+    LEPT_BIND_FIELD(id)
+    LEPT_BIND_FIELD(name)
+    LEPT_BIND_FIELD(score)
+    LEPT_BIND_FIELD(active)
+    LEPT_BIND_FIELD(tags)
+    LEPT_BIND_FIELD(pos)
+    LEPT_BIND_FIELD_AS(path, "trail")
+    LEPT_BIND_FIELD(level)
+    LEPT_BIND_FIELD(ratio)
+    LEPT_BIND_FIELD(flags)
+LEPT_BIND_END()
+
+/** 同时用 lept_parse 与 lept_parse_into 解析，语法错误应当相同，合法的文本只会有类型或范围的错误 */
+lept_parse_ret parse_bind(const char *json, const lept_parse_options &options = lept_parse_options())
+{
+    bind_record r;
+    lept_value v;
+    lept_parse_ret ret = lept_parse_into(r, json, options), expect = lept_value::lept_parse(v, json, options);
+    if (expect != LEPT_PARSE_OK ? ret != expect
+                                : ret != LEPT_PARSE_OK && ret != LEPT_PARSE_TYPE_MISMATCH && ret != LEPT_PARSE_NUMBER_TOO_BIG)
+        return LEPT_PARSE_INCOMPLETE; // 不该出现的组合
+    return ret;
+}
+
+void test_bind()
+{
+#if 1 // 字段
+    const char *json = "{\"id\":9007199254740993,\"name\":\"a\\u00e9\",\"score\":2.5,\"active\":true,"
+                       "\"tags\":[\"x\",\"y\"],\"pos\":{\"x\":1,\"y\":-2,\"z\":[{}]},\"trail\":[{\"x\":3},{\"y\":4}],"
+                       "\"extra\":{\"a\":[1,\"}\",null]},\"level\":255,\"ratio\":0.5,\"flags\":[true,false,null,true]}";
+    bind_record r;
+    EXPECT_EQ(LEPT_PARSE_OK, lept_parse_into(r, json));
+    EXPECT_EQ((int64_t)9007199254740993, r.id);
+    EXPECT_EQ(std::string("a\xc3\xa9"), r.name);
+    EXPECT_EQ(2.5, r.score);
+    EXPECT_EQ(true, r.active);
+    EXPECT_EQ((size_t)2, r.tags.size());
+    EXPECT_EQ(std::string("y"), r.tags[1]);
+    EXPECT_EQ(1, r.pos.x);
+    EXPECT_EQ(-2, r.pos.y);
+    EXPECT_EQ((size_t)2, r.path.size());
+    EXPECT_EQ(3, r.path[0].x);
+    EXPECT_EQ(0, r.path[0].y);
+    EXPECT_EQ(4, r.path[1].y);
+    EXPECT_EQ(255, (int)r.level);
+    EXPECT_EQ(0.5f, r.ratio);
+    EXPECT_EQ((size_t)4, r.flags.size()); // null 的元素保持默认值
+    EXPECT_EQ(true, r.flags[0] && !r.flags[1] && !r.flags[2] && r.flags[3]);
+#endif
+
+#if 1 // 缺少的字段与 null 保持原样，含转义的键，重复的键取最后一个
+    bind_record d;
+    EXPECT_EQ(LEPT_PARSE_OK, lept_parse_into(d, " { \"n\\u0061me\" : \"k\", \"score\" : null, \"tags\" : [], "
+                                                "\"score\" : 1e2, \"id\" : 1.0 } "));
+    EXPECT_EQ(std::string("k"), d.name);
+    EXPECT_EQ(100.0, d.score);
+    EXPECT_EQ((int64_t)1, d.id);
+    EXPECT_EQ((size_t)0, d.tags.size());
+    EXPECT_EQ(false, d.active);
+    d.active = true;
+    EXPECT_EQ(LEPT_PARSE_OK, lept_parse_into(d, "{\"active\":null,\"ratio\":null}"));
+    EXPECT_EQ(true, d.active);
+
+    std::vector<bind_pos> list;
+    EXPECT_EQ(LEPT_PARSE_OK, lept_parse_into(list, "[{\"x\":1},{\"x\":2}]"));
+    EXPECT_EQ((size_t)2, list.size());
+    EXPECT_EQ(2, list[1].x);
+#endif
+
+#if 1 // 类型不符与范围
+    EXPECT_EQ(LEPT_PARSE_TYPE_MISMATCH, parse_bind("{\"id\":\"1\"}"));
+    EXPECT_EQ(LEPT_PARSE_TYPE_MISMATCH, parse_bind("{\"id\":1.5}"));
+    EXPECT_EQ(LEPT_PARSE_TYPE_MISMATCH, parse_bind("{\"tags\":[1]}"));
+    EXPECT_EQ(LEPT_PARSE_TYPE_MISMATCH, parse_bind("{\"pos\":[]}"));
+    EXPECT_EQ(LEPT_PARSE_TYPE_MISMATCH, parse_bind("{\"active\":0}"));
+    EXPECT_EQ(LEPT_PARSE_TYPE_MISMATCH, parse_bind("{\"flags\":[true,1]}"));
+    EXPECT_EQ(LEPT_PARSE_TYPE_MISMATCH, parse_bind("[]"));
+    EXPECT_EQ(LEPT_PARSE_NUMBER_TOO_BIG, parse_bind("{\"level\":256}"));
+    EXPECT_EQ(LEPT_PARSE_NUMBER_TOO_BIG, parse_bind("{\"level\":-1}"));
+    EXPECT_EQ(LEPT_PARSE_NUMBER_TOO_BIG, parse_bind("{\"id\":9223372036854775808}"));
+    EXPECT_EQ(LEPT_PARSE_NUMBER_TOO_BIG, parse_bind("{\"id\":1e19}"));
+    EXPECT_EQ(LEPT_PARSE_MISS_KEY, parse_bind("{\"id\":\"1\",x:1}")); // 整个文本合法时才报告类型不符
+    EXPECT_EQ(LEPT_PARSE_ROOT_NOT_SINGULAR, parse_bind("{\"level\":256} 1"));
+    EXPECT_EQ(LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, parse_bind("{\"id\":[1}"));
+#endif
+
+#if 1 // 语法错误与 lept_parse 相同
+    static const char *errors[] = {"",
+                                   " ",
+                                   "{",
+                                   "{\"id\"",
+                                   "{\"id\":",
+                                   "{\"id\" 1}",
+                                   "{\"id\":1,}",
+                                   "{\"id\":1 \"name\":\"x\"}",
+                                   "{\"id\":01}",
+                                   "{\"name\":\"abc}",
+                                   "{\"name\":\"\\x\"}",
+                                   "{\"name\":\"\\ud800\"}",
+                                   "{1:1}",
+                                   "{\"tags\":[\"a\" \"b\"]}",
+                                   "{\"tags\":[\"a\",]}",
+                                   "{\"extra\":[1,2}",
+                                   "{\"extra\":{\"a\" 1}}",
+                                   "{\"extra\":nul}",
+                                   "{\"active\":tru}",
+                                   "{\"score\":1e999}",
+                                   "{\"pos\":{\"x\":1,}}",
+                                   "{\"id\":1} x",
+                                   "{\"id\":1}}"};
+    for (const char *e : errors)
+    {
+        lept_value v;
+        lept_parse_ret expect = lept_value::lept_parse(v, e);
+        EXPECT_EQ(true, expect != LEPT_PARSE_OK);
+        EXPECT_EQ(expect, parse_bind(e));
+    }
+    lept_parse_options options;
+    options.max_depth = 3;
+    EXPECT_EQ(LEPT_PARSE_OK, parse_bind("{\"trail\":[{\"x\":1}],\"extra\":[[1]]}", options));
+    EXPECT_EQ(LEPT_PARSE_TOO_DEEP, parse_bind("{\"trail\":[{\"x\":[]}]}", options));
+    EXPECT_EQ(LEPT_PARSE_TOO_DEEP, parse_bind("{\"extra\":[[[1]]]}", options));
+#endif
+
+#if 1 // 字段较多时散列也没有冲突
+    lept_field_name names[200];
+    std::vector<std::string> keys(200);
+    for (int i = 0; i < 200; i++)
+    {
+        keys[i] = "field_" + std::to_string(i);
+        names[i].name = keys[i].data();
+        names[i].len = keys[i].size();
+    }
+    lept_field_table t;
+    lept_make_field_table(t, names, 200);
+    int found = 0;
+    for (int i = 0; i < 200; i++)
+        found += t.slots[lept_field_hash(names[i].name, names[i].len, t.seed) & t.mask] == i;
+    EXPECT_EQ(200, found);
+#endif
+}
+
+/** 以各种方式按最大深度 max_depth 解析 json，返回都相同的错误码；彼此不同时输出各自的结果并返回 LEPT_PARSE_INCOMPLETE */
+lept_parse_ret parse_depth(const std::string &json, size_t max_depth)
+{
+    lept_parse_options options;
+    options.max_depth = max_depth;
+    lept_value v;
+    lept_parse_ret ret = lept_value::lept_parse(v, json, options);
+    options.engine = LEPT_ENGINE_INDEXED;
+    lept_parse_ret indexed = lept_value::lept_parse(v, json, options);
+    options.engine = LEPT_ENGINE_DESCENT;
+    lept_stream st(options);
+    st.lept_feed(json.data(), json.size());
+    lept_parse_ret stream = st.lept_finish(v);
+    record_handler h;
+    lept_reader r;
+    r.json = json.data();
+    r.end = json.data() + json.size();
+    r.max_depth = max_depth;
+    lept_parse_ret events = lept_parse_events(r, h);
+    lept_parse_ret parallel = lept_value::lept_parse_parallel(v, json.data(), json.size(), 2, options);
+    lept_parse_ret lazy = lept_lazy_value::lept_parse(json.data(), json.size()).lept_get_value(v, options);
+    if (ret == indexed && ret == stream && ret == events && ret == parallel && ret == lazy)
+        return ret;
+    std::cerr << "depth mismatch: " << ret << ' ' << indexed << ' ' << stream << ' ' << events << ' ' << parallel
+              << ' ' << lazy << '\n';
+    return LEPT_PARSE_INCOMPLETE;
+}
+
+void test_parse_depth()
+{
+    EXPECT_EQ((size_t)1024, lept_parse_options().max_depth);
+    EXPECT_EQ(LEPT_PARSE_OK, parse_depth("[[[1]]]", 3));
+    EXPECT_EQ(LEPT_PARSE_OK, parse_depth("{\"a\":[{\"b\":null}],\"c\":[[1],[2]]}", 3));
+    EXPECT_EQ(LEPT_PARSE_TOO_DEEP, parse_depth("[[[[1]]]]", 3));
+    EXPECT_EQ(LEPT_PARSE_TOO_DEEP, parse_depth("[[[[]]]]", 3));
+    EXPECT_EQ(LEPT_PARSE_TOO_DEEP, parse_depth("{\"a\":{\"b\":{\"c\":{}}}}", 3));
+    EXPECT_EQ(LEPT_PARSE_TOO_DEEP, parse_depth("[[[[1", 3));                 // 先于缺少的括号发现
+    EXPECT_EQ(LEPT_PARSE_MISS_COMMA_OR_SQUARE_BRACKET, parse_depth("[[1 2],[[[1]]]]", 3)); // 位置靠前的错误优先
+    EXPECT_EQ(LEPT_PARSE_TOO_DEEP, parse_depth("[1,[2,[3,[4]]],5,x]", 3));
+    EXPECT_EQ(LEPT_PARSE_OK, parse_depth("\"s\"", 0));
+    EXPECT_EQ(LEPT_PARSE_TOO_DEEP, parse_depth("[]", 0));
+
+    /* 深度不受限时也不递归，100000 层只用显式的栈 */
+    std::string deep = std::string(100000, '[') + std::string(100000, ']');
+    EXPECT_EQ(LEPT_PARSE_TOO_DEEP, parse_depth(deep, 1024));
+    lept_reader r;
+    r.json = deep.data();
+    r.end = deep.data() + deep.size();
+    r.max_depth = 100000;
+    record_handler h;
+    EXPECT_EQ(LEPT_PARSE_OK, lept_parse_events(r, h));
+    EXPECT_EQ((size_t)100000 * 5, h.events.size()); // 每层 "[ " 与 "]n "
+
+    /* 释放、拷贝、序列化与编码同样不递归，一百万层的树也不会耗尽调用栈 */
+    const size_t levels = 1000000;
+    deep = std::string(levels, '[') + "{\"k\":\"v\"}" + std::string(levels, ']');
+    lept_parse_options options;
+    options.max_depth = levels + 1;
+    {
+        lept_value v;
+        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_parse(v, deep, options));
+        lept_buffer b;
+        lept_value::lept_stringify(v, b);
+        EXPECT_EQ(deep, std::string(b.lept_get_data(), b.lept_get_size()));
+
+        lept_value copy(v);
+        v = lept_value();
+        b.lept_clear();
+        lept_value::lept_encode(copy, b);
+        EXPECT_EQ(LEPT_PARSE_TOO_DEEP, lept_value::lept_decode(v, b.lept_get_data(), b.lept_get_size()));
+        EXPECT_EQ(LEPT_PARSE_OK, lept_value::lept_decode(v, b.lept_get_data(), b.lept_get_size(), options));
+        EXPECT_EQ(LEPT_ARRAY, v.lept_get_type());
+    }
+    lept_document d;
+    d.lept_set_options(options);
+    EXPECT_EQ(LEPT_PARSE_OK, d.lept_parse(deep));
+    lept_value copy(d.lept_get_root()); // 借用 arena 的树拷贝成持有内容的树
+    EXPECT_EQ(LEPT_ARRAY, copy.lept_get_type());
+}
+
 void test_parse()
 {
     test_parse_null();
@@ -367,9 +2203,34 @@ void test_parse()
     test_parse_error_value();
 
     test_parse_number();
+    test_parse_integer();
     test_parse_string();
+    test_parse_string_simd();
+    test_parse_length();
     test_parse_array();
     test_parse_object();
+    test_parse_nested();
+    test_access();
+    test_object_index();
+
+    test_value();
+    test_document();
+    test_intern();
+    test_parse_events();
+    test_parse_file();
+    test_parse_insitu();
+    test_lazy();
+    test_stream();
+    test_stringify();
+    test_engine();
+    test_batch();
+    test_parse_parallel();
+    test_stats();
+    test_parse_depth();
+    test_tape();
+    test_pointer();
+    test_path();
+    test_bind();
 }
 
 int main()